@@ -0,0 +1,8 @@
+
+
+n
+y
+
+
+
+
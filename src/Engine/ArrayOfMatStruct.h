@@ -75,12 +75,16 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 
 /*! \file ArrayOfMatStruct.h
  *
+ *  The non-zero quantum number blocks of a sparse operator, stored as
+ *  dense matrices. Row group ig of the operator has blocks(ig) non-zero
+ *  blocks; block k connects it to column group col(ig,k)
  *
  */
 
 #ifndef ARRAY_OF_MAT_STRUCT_H
 #define ARRAY_OF_MAT_STRUCT_H
 #include "CrsMatrix.h"
+#include "Matrix.h"
 
 namespace Dmrg {
 
@@ -90,95 +94,66 @@ class ArrayOfMatStruct {
 public:
 
 	typedef typename SparseMatrixType::value_type ComplexOrRealType;
-
-	ArrayOfMatStruct() {}
-
-	ArrayOfMatStruct(const SparseMatrixType& sparse,GenGroupType& istart)
-	: data_(istart.size()-1,istart.size()-1)
+	typedef PsimagLite::Matrix<ComplexOrRealType> MatrixType;
+
+	//! Row alpha of sparse is multiplied by rowFactors[alpha] if rowFactors is not empty
+	ArrayOfMatStruct(const SparseMatrixType& sparse,
+	                 const GenGroupType& istart,
+	                 const std::vector<ComplexOrRealType>& rowFactors = std::vector<ComplexOrRealType>())
+	: cols_(istart.size()-1),
+	  blocks_(istart.size()-1)
 	{
 		size_t ngroup = istart.size()-1;
-		//SparseMatrixType tmp2;
-
-		for (size_t j=0;j<ngroup;j++) {
-			size_t j1 = istart(j);
-			size_t j2 = istart(j+1);
-			std::vector<ComplexOrRealType> p(j2-j1,0.0);
-			std::vector<bool> mark(j2-j1,false);
-//			if (j1>=j2) continue;
-			for (size_t i=0;i<ngroup;i++) {
-				size_t i1 = istart(i);
-				size_t i2 = istart(i+1);
-//				if (i1>=i2) continue;
-
-				//tmp2.resize(i2-i1,j2-j1);
-				data_(i,j) = SparseMatrixType(i2-i1,j2-j1);
-				SparseMatrixType& tmp = data_(i,j);
-				size_t counter = 0;
-
-				for (size_t ii=i1;ii<i2;ii++) {
-					size_t row = ii - i1;
-					tmp.setRow(row,counter);
-
-
-					size_t start = sparse.getRowPtr(ii);
-					size_t end = sparse.getRowPtr(ii+1);
-					size_t minCol = 0;
-					size_t maxCol = p.size()-1;
-					for (size_t k = start;k<end;k++) {
-						int col = sparse.getCol(k)-j1;
-						if (col<0) continue;
-						if (size_t(col)>=j2-j1) continue; // ARE COLUMNS SORTED?
-						p[col] += sparse.getValue(k);
-						mark[col] = true;
-						if (size_t(col)<minCol) minCol = col;
-						if (size_t(col)>maxCol) maxCol = col;
-					}
-
-					for (size_t rr=minCol;rr<=maxCol;rr++) {
-						if (!mark[rr]) continue;
-						tmp.pushCol(rr);
-						tmp.pushValue(p[rr]);
-						p[rr] = 0.0;
-						mark[rr] = false;
-						counter++;
+		std::vector<size_t> groupOf(sparse.col());
+		for (size_t g=0;g<ngroup;g++)
+			for (size_t jj=istart(g);jj<istart(g+1);jj++) groupOf[jj] = g;
+
+		std::vector<int> whichBlock(ngroup,-1);
+		for (size_t i=0;i<ngroup;i++) {
+			size_t i1 = istart(i);
+			size_t i2 = istart(i+1);
+
+			for (size_t ii=i1;ii<i2;ii++) {
+				ComplexOrRealType factor = (rowFactors.size()>0) ? rowFactors[ii] : 1.0;
+				for (int k=sparse.getRowPtr(ii);k<sparse.getRowPtr(ii+1);k++) {
+					size_t col = sparse.getCol(k);
+					size_t j = groupOf[col];
+					if (whichBlock[j]<0) {
+						whichBlock[j] = cols_[i].size();
+						cols_[i].push_back(j);
+						blocks_[i].push_back(MatrixType(i2-i1,istart(j+1)-istart(j)));
 					}
+					MatrixType& m = blocks_[i][whichBlock[j]];
+					m(ii-i1,col-istart(j)) += factor*sparse.getValue(k);
 				}
-				tmp.setRow(i2-i1,counter);
-				tmp.checkValidity();
 			}
+
+			for (size_t k=0;k<cols_[i].size();k++) whichBlock[cols_[i][k]] = -1;
 		}
 	}
 
-	const SparseMatrixType& operator()(size_t i,size_t j) const
+	size_t blocks(size_t i) const
 	{
-		assert(i<data_.n_row() && j<data_.n_col());
-		return data_(i,j);
+		assert(i<cols_.size());
+		return cols_[i].size();
 	}
 
-	~ArrayOfMatStruct()
+	size_t col(size_t i,size_t k) const
 	{
-//		for (size_t j=0;j<data_.n_row();j++)
-//			for (size_t i=0;i<data_.n_col();i++)
-//				if (data_(i,j)) delete data_(i,j);
+		assert(i<cols_.size() && k<cols_[i].size());
+		return cols_[i][k];
 	}
 
-private:
-
-//	ArrayOfMatStruct& operator=(ArrayOfMatStruct& other)
-//	{
-//		throw std::runtime_error("operator= is disabled\n");
-//	}
-
-//	ArrayOfMatStruct(ArrayOfMatStruct& other)
-//	{
-//		throw std::runtime_error("copy ctor is disabled\n");
-//	}
-
-//	ArrayOfMatStruct(const ArrayOfMatStruct& other);
+	const MatrixType& operator()(size_t i,size_t k) const
+	{
+		assert(i<blocks_.size() && k<blocks_[i].size());
+		return blocks_[i][k];
+	}
 
-//	ArrayOfMatStruct& operator=(const ArrayOfMatStruct& other);
+private:
 
-	PsimagLite::Matrix<SparseMatrixType> data_;
+	std::vector<std::vector<size_t> > cols_;
+	std::vector<std::vector<MatrixType> > blocks_;
 
 }; //class ArrayOfMatStruct
 } // namespace Dmrg
@@ -127,6 +127,8 @@ namespace Dmrg {
 		typedef BasisWithOperators<OperatorsType,ConcurrencyType> 	ThisType;
 		typedef typename BasisType::BasisDataType BasisDataType;
 		typedef typename BasisType::FactorsType FactorsType;
+		typedef typename OperatorsType::OperatorChainType OperatorChainType;
+		typedef typename OperatorsType::OperatorChainStepType OperatorChainStepType;
 
 		enum {GROW_RIGHT,GROW_LEFT};
 
@@ -150,62 +152,56 @@ namespace Dmrg {
 		}
 
 		//! set this basis to the outer product of   basis2 and basis3 or basis3 and basis2  depending on dir
-		void setToProduct(const ThisType& basis2,const ThisType& basis3,int dir)
+		void setToProduct(const ThisType& basis2,
+		                  const ThisType& basis3,
+		                  int dir,
+		                  const ConcurrencyType& concurrency,
+		                  size_t nthreads = 1)
 		{
-			if (dir==GROW_RIGHT) setToProduct(basis2,basis3);
-			else setToProduct(basis3,basis2);
+			if (dir==GROW_RIGHT) setToProduct(basis2,basis3,concurrency,nthreads);
+			else setToProduct(basis3,basis2,concurrency,nthreads);
 		}
 
 		//! set this basis to the outer product of   basis2 and basis3 
+		//! Without SU(2) operators and Hamiltonian are written directly in
+		//! the reordered basis, see ExternalProductReordered.h
 		//!PTEX_LABEL{setToProductOps}
-		void setToProduct(const ThisType& basis2,const ThisType& basis3)
+		void setToProduct(const ThisType& basis2,
+		                  const ThisType& basis3,
+		                  const ConcurrencyType& concurrency,
+		                  size_t nthreads = 1)
 		{
 			BasisType &parent = *this;
 			// reorder the basis
 			parent.setToProduct(basis2,basis3);
 
-			std::vector<double> fermionicSigns;
 			size_t x = basis2.numberOfOperators()+basis3.numberOfOperators();
 
 			if (this->useSu2Symmetry()) setMomentumOfOperators(basis2);
 			operators_.setToProduct(basis2,basis3,x,this);
-			ApplyFactors<FactorsType> apply(this->getFactors(),this->useSu2Symmetry());
-			int savedSign = 0;
 
-			for (size_t i=0;i<this->numberOfOperators();i++) {
-				if (i<basis2.numberOfOperators()) {
-					if (!this->useSu2Symmetry()) {
-						const OperatorType& myOp =  basis2.getOperatorByIndex(i);
-						if (savedSign != myOp.fermionSign) {
-							fillFermionicSigns(fermionicSigns,basis2.electronsVector(),myOp.fermionSign);
-							savedSign = myOp.fermionSign;
-						}
-						operators_.externalProduct(i,myOp,basis3.size(),fermionicSigns,true,apply);
-					} else {
-						operators_.externalProductReduced(i,basis2,basis3,true,basis2.getReducedOperatorByIndex(i));
-					}
-				} else {
-					if (!this->useSu2Symmetry()) {
-						const OperatorType& myOp = basis3.getOperatorByIndex(i-basis2.numberOfOperators());
-
-						if (savedSign != myOp.fermionSign) {
-							fillFermionicSigns(fermionicSigns,basis2.electronsVector(),myOp.fermionSign);
-							savedSign = myOp.fermionSign;
-						}
-						operators_.externalProduct(i,myOp,basis2.size(),fermionicSigns,false,apply);
-					} else {
-						operators_.externalProductReduced(i,basis2,basis3,false,
-						   basis3.getReducedOperatorByIndex(i-basis2.numberOfOperators()));
-					}
-				}
+			if (this->useSu2Symmetry()) {
+				setToProductSu2(basis2,basis3);
+			} else if (OperatorsType::lazyOperators()) {
+				setToProductDeferred(basis2,basis3);
+			} else {
+				std::vector<const OperatorType*> sources(x);
+				for (size_t i=0;i<basis2.numberOfOperators();i++)
+					sources[i] = &basis2.getOperatorByIndex(i);
+				for (size_t i=0;i<basis3.numberOfOperators();i++)
+					sources[i+basis2.numberOfOperators()] = &basis3.getOperatorByIndex(i);
+				operators_.externalProductReordered(sources,basis2.numberOfOperators(),
+				                                    basis2.size(),basis3.size(),
+				                                    basis2.electronsVector(),
+				                                    this->permutationVector(),
+				                                    concurrency,nthreads);
 			}
 
-			//! Calc. hamiltonian
-			operators_.outerProductHamiltonian(basis2.hamiltonian(),basis3.hamiltonian(),apply);
-			operators_.outerProductHamiltonianReduced(basis2,basis3,basis2.reducedHamiltonian(),basis3.reducedHamiltonian());
-			//! re-order operators and hamiltonian 
-			operators_.reorder(this->permutationVector());
-			
+			if (!this->useSu2Symmetry())
+				operators_.outerProductHamiltonianReordered(basis2.hamiltonian(),
+				                                            basis3.hamiltonian(),
+				                                            this->permutationVector());
+
 			size_t offset1 = basis2.operatorsPerSite_.size();
 			operatorsPerSite_.resize(offset1+basis3.operatorsPerSite_.size());
 			for (size_t i=0;i<offset1;i++)
@@ -231,27 +227,59 @@ namespace Dmrg {
 				       const BlockMatrixType& transform,
 				       const std::vector<RealType>& eigs,
 				       const std::vector<size_t>& removedIndices,
-				       ConcurrencyType& concurrency)
+				       ConcurrencyType& concurrency,
+				       size_t nthreads = 1,
+				       size_t borderSites = 0,
+				       bool borderIsLast = true)
 		{
 			BasisType &parent = *this;
 			RealType error = parent.truncateBasis(ftransform,transform,eigs,removedIndices);
 
-			changeBasisDirect(ftransform,concurrency);
+			changeBasisDirect(ftransform,concurrency,nthreads,borderSites,borderIsLast);
 
 			return error;
 		}
 
-		void changeBasisDirect(const SparseMatrixType& ftransform, ConcurrencyType& concurrency)
+		//! If borderSites>0, only the operators of the borderSites last (or
+		//! first if !borderIsLast) sites of the block are kept, the others
+		//! are dropped. Ignored with SU(2)
+		void changeBasisDirect(const SparseMatrixType& ftransform,
+				       ConcurrencyType& concurrency,
+				       size_t nthreads = 1,
+				       size_t borderSites = 0,
+				       bool borderIsLast = true)
 		{
-			operators_.changeBasis(ftransform,this,concurrency); //startEnd);
+			PairType startEnd(0,this->numberOfOperators());
+			if (borderSites>0 && !this->useSu2Symmetry())
+				startEnd = operatorsOfBorderSites(borderSites,borderIsLast);
+			operators_.changeBasis(ftransform,this,concurrency,startEnd,nthreads);
+		}
+
+		//! Range of indices of the operators of the n last sites of
+		//! this block, or of the n first sites if !last
+		PairType operatorsOfBorderSites(size_t n,bool last) const
+		{
+			size_t sites = operatorsPerSite_.size();
+			if (n>sites) n = sites;
+			size_t first = (last) ? sites - n : 0;
+			size_t end = (last) ? sites : n;
+			size_t start = 0;
+			for (size_t i=0;i<first;i++) start += operatorsPerSite_[i];
+			size_t stop = start;
+			for (size_t i=first;i<end;i++) stop += operatorsPerSite_[i];
+			return PairType(start,stop);
 		}
 
 		void setHamiltonian(SparseMatrixType const &h) { operators_.setHamiltonian(h); }
 
 		//! Returns the Hamiltonian as stored in this basis
-		SparseMatrixType hamiltonian() const { return operators_.hamiltonian(); }
+		const SparseMatrixType& hamiltonian() const { return operators_.hamiltonian(); }
+
+		SparseMatrixType& hamiltonianNonConst() { return operators_.hamiltonianNonConst(); }
 
-		SparseMatrixType reducedHamiltonian() const { return operators_.reducedHamiltonian(); }
+		void hamiltonianChanged() { operators_.hamiltonianChanged(); }
+
+		const SparseMatrixType& reducedHamiltonian() const { return operators_.reducedHamiltonian(); }
 
 		void setVarious(BlockType const &block,
 		                SparseMatrixType const &h,
@@ -334,16 +362,57 @@ namespace Dmrg {
 			io.printVector(operatorsPerSite_,"#OPERATORSPERSITE");
 		}
 
+		template<typename IoOutputter>
+		void saveWithoutOperators(IoOutputter& io) const
+		{
+			BasisType::save(io); // parent saves
+			operators_.saveWithoutOperators(io);
+			io.printVector(operatorsPerSite_,"#OPERATORSPERSITE");
+		}
+
 	private:
 		OperatorsType operators_;
 		std::vector<size_t> operatorsPerSite_;
 
-		template<typename SomeType>
-		void fillFermionicSigns(std::vector<SomeType>& fermionicSigns,const std::vector<size_t>& electrons,int f)
+		void setToProductSu2(const ThisType& basis2,const ThisType& basis3)
+		{
+			ApplyFactors<FactorsType> apply(this->getFactors(),this->useSu2Symmetry());
+			for (size_t i=0;i<this->numberOfOperators();i++) {
+				if (i<basis2.numberOfOperators()) {
+					operators_.externalProductReduced(i,basis2,basis3,true,basis2.getReducedOperatorByIndex(i));
+				} else {
+					operators_.externalProductReduced(i,basis2,basis3,false,
+					   basis3.getReducedOperatorByIndex(i-basis2.numberOfOperators()));
+				}
+			}
+
+			//! Calc. hamiltonian
+			operators_.outerProductHamiltonian(basis2.hamiltonian(),basis3.hamiltonian(),apply);
+			operators_.outerProductHamiltonianReduced(basis2,basis3,basis2.reducedHamiltonian(),basis3.reducedHamiltonian());
+			//! re-order operators and hamiltonian 
+			operators_.reorder(this->permutationVector());
+		}
+
+		// growth steps for deferred operators, see OperatorChain.h
+		void setToProductDeferred(const ThisType& basis2,const ThisType& basis3)
 		{
-			fermionicSigns.resize(electrons.size());
-			for (size_t i=0;i<fermionicSigns.size();i++)
-				fermionicSigns[i]= (electrons[i]%2==0) ? 1.0 : static_cast<double>(f);
+			OperatorChainType owner;
+			const OperatorChainStepType* growLeft = new OperatorChainStepType(basis3.size(),true,
+			                                                 basis2.electronsVector(),
+			                                                 this->permutationVector());
+			owner.push(growLeft);
+			const OperatorChainStepType* growRight = new OperatorChainStepType(basis2.size(),false,
+			                                                  basis2.electronsVector(),
+			                                                  this->permutationVector());
+			owner.push(growRight);
+
+			for (size_t i=0;i<this->numberOfOperators();i++) {
+				if (i<basis2.numberOfOperators())
+					operators_.externalProductDeferred(i,basis2.operators_,i,growLeft);
+				else
+					operators_.externalProductDeferred(i,basis3.operators_,
+					                            i-basis2.numberOfOperators(),growRight);
+			}
 		}
 
 		void setMomentumOfOperators(const ThisType& basis)
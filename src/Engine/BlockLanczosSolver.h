@@ -0,0 +1,435 @@
+/*
+Copyright (c) 2013, UT-Battelle, LLC
+All rights reserved
+
+[DMRG++, Version 2.0.0]
+[by G.A., Oak Ridge National Laboratory]
+
+UT Battelle Open Source Software License 11242008
+
+OPEN SOURCE LICENSE
+
+Subject to the conditions of this License, each
+contributor to this software hereby grants, free of
+charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), a
+perpetual, worldwide, non-exclusive, no-charge,
+royalty-free, irrevocable copyright license to use, copy,
+modify, merge, publish, distribute, and/or sublicense
+copies of the Software.
+
+1. Redistributions of Software must retain the above
+copyright and license notices, this list of conditions,
+and the following disclaimer.  Changes or modifications
+to, or derivative works of, the Software should be noted
+with comments and the contributor and organization's
+name.
+
+2. Neither the names of UT-Battelle, LLC or the
+Department of Energy nor the names of the Software
+contributors may be used to endorse or promote products
+derived from this software without specific prior written
+permission of UT-Battelle.
+
+3. The software and the end-user documentation included
+with the redistribution, with or without modification,
+must include the following acknowledgment:
+
+"This product includes software produced by UT-Battelle,
+LLC under Contract No. DE-AC05-00OR22725  with the
+Department of Energy."
+
+*********************************************************
+DISCLAIMER
+
+THE SOFTWARE IS SUPPLIED BY THE COPYRIGHT HOLDERS AND
+CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER, CONTRIBUTORS, UNITED STATES GOVERNMENT,
+OR THE UNITED STATES DEPARTMENT OF ENERGY BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+DAMAGE.
+
+NEITHER THE UNITED STATES GOVERNMENT, NOR THE UNITED
+STATES DEPARTMENT OF ENERGY, NOR THE COPYRIGHT OWNER, NOR
+ANY OF THEIR EMPLOYEES, REPRESENTS THAT THE USE OF ANY
+INFORMATION, DATA, APPARATUS, PRODUCT, OR PROCESS
+DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
+
+*********************************************************
+
+
+*/
+// END LICENSE BLOCK
+/** \ingroup DMRG */
+/*@{*/
+/*! \file BlockLanczosSolver.h
+ *
+ *  The ground state of a Hermitian matrix by a restarted block Lanczos.
+ *  The Krylov space is built from blocks of blockSize vectors, so that
+ *  each application of the matrix is a matrix-matrix product
+ *  (see InternalProductOnTheFly::matrixMatrixProduct) that loads
+ *  each Hamiltonian term once for all the vectors of the block
+ *
+ */
+
+#ifndef BLOCK_LANCZOS_SOLVER_H
+#define BLOCK_LANCZOS_SOLVER_H
+
+#include <vector>
+#include <stdexcept>
+#include <sstream>
+#include <cmath>
+#include <algorithm>
+#include "Matrix.h"
+#include "Random48.h"
+#include "ProgressIndicator.h"
+#include "KrylovWorkspace.h"
+
+namespace Dmrg {
+
+template<typename ParametersForSolverType,typename MatrixType,typename VectorType>
+class BlockLanczosSolver {
+
+	typedef typename VectorType::value_type ComplexOrRealType;
+	typedef typename MatrixType::RealType RealType;
+	typedef PsimagLite::Matrix<ComplexOrRealType> DenseMatrixType;
+	// blockSize_ vectors stored interleaved: entry i of vector v is block[i*blockSize_+v]
+	typedef std::vector<ComplexOrRealType> BlockType;
+
+	enum {MAX_KRYLOV_VECTORS = 64};
+
+public:
+
+	typedef KrylovWorkspace<ComplexOrRealType> KrylovWorkspaceType;
+
+	//! params.steps bounds the number of vectors in the Krylov space before a restart,
+	//! params.stepsForEnergyConvergence bounds the number of vectors the matrix is
+	//! applied to, and params.tolerance is the convergence criterion on the lowest eigenvalue.
+	//! The Krylov blocks are kept in workspace if given, so that they can be reused
+	//! by the next solver
+	BlockLanczosSolver(MatrixType& mat,
+	                   const ParametersForSolverType& params,
+	                   size_t blockSize,
+	                   KrylovWorkspaceType* workspace = 0)
+	: mat_(mat),
+	  params_(params),
+	  n_(mat.rank()),
+	  blockSize_((blockSize<n_) ? blockSize : n_),
+	  workspace_((workspace) ? *workspace : ownWorkspace_),
+	  progress_("BlockLanczos",0),
+	  rng_(343311)
+	{
+		if (blockSize==0) {
+			std::string s(__FILE__);
+			s += " block size must be positive\n";
+			throw std::runtime_error(s.c_str());
+		}
+	}
+
+	void computeGroundState(RealType& gsEnergy,VectorType& z,const VectorType& initialVector)
+	{
+		std::vector<RealType> eigs;
+		BlockType x;
+		computeLowest(eigs,x,initialVector);
+		gsEnergy = eigs[0];
+		z.resize(n_);
+		for (size_t i=0;i<n_;i++) z[i] = x[i*blockSize_];
+	}
+
+private:
+
+	// workspace_(j) for j<=maxBlocks holds the Krylov blocks, the last one being
+	// the residual of the last step; workspace_(maxBlocks+1) holds the Ritz block
+	void computeLowest(std::vector<RealType>& eigs,BlockType& x,const VectorType& initialVector)
+	{
+		size_t k = blockSize_;
+		size_t maxVectors = (params_.steps<MAX_KRYLOV_VECTORS) ? params_.steps : MAX_KRYLOV_VECTORS;
+		size_t maxBlocks = maxVectors/k;
+		if (maxBlocks<2) maxBlocks = 2;
+		// so that there is always room for the vectors that replace
+		// a deflated column of the residual
+		if (maxBlocks>n_/k) maxBlocks = n_/k;
+		if (maxBlocks<2) {
+			computeLowestDense(eigs,x);
+			return;
+		}
+		size_t maxApplied = params_.stepsForEnergyConvergence;
+
+		workspace_.resize(maxBlocks+2,n_*k);
+		BlockType& ritz = workspace_(maxBlocks+1);
+		initialBlock(workspace_(0),initialVector);
+
+		DenseMatrixType ritzVectors;
+		size_t applied = 0;
+		RealType eold = 0;
+		bool converged = false;
+
+		while (true) {
+			DenseMatrixType t(maxBlocks*k,maxBlocks*k);
+			size_t nblocks = 1;
+
+			for (size_t j=0;;j++) {
+				const BlockType& q = workspace_(j);
+				BlockType& w = workspace_(j+1);
+				std::fill(w.begin(),w.end(),ComplexOrRealType(0.0));
+				mat_.matrixMatrixProduct(w,q,k);
+				applied += k;
+
+				DenseMatrixType c(k,k);
+				innerProduct(c,q,w);
+				for (size_t a=0;a<k;a++)
+					for (size_t b=0;b<k;b++)
+						t(j*k+a,j*k+b) = 0.5*(c(a,b)+std::conj(c(b,a)));
+
+				// w -= Q_j A_j + Q_{j-1} B_j^H
+				for (size_t a=0;a<k;a++)
+					for (size_t b=0;b<k;b++) c(a,b) = t(j*k+a,j*k+b);
+				subtract(w,q,c);
+				if (j>0) {
+					for (size_t a=0;a<k;a++)
+						for (size_t b=0;b<k;b++) c(a,b) = t((j-1)*k+a,j*k+b);
+					subtract(w,workspace_(j-1),c);
+				}
+
+				// full reorthogonalization, the basis is short
+				for (size_t i=0;i<=j;i++) {
+					innerProduct(c,workspace_(i),w);
+					subtract(w,workspace_(i),c);
+				}
+
+				diagonalise(eigs,ritzVectors,t,(j+1)*k);
+				// at j=0 of a restart the lowest eigenvalue is that of the
+				// Ritz block of the previous cycle, so there is nothing to compare
+				if (j>0 && fabs(eigs[0]-eold)<params_.tolerance) converged = true;
+				eold = eigs[0];
+				if (converged || applied>=maxApplied || j+1==maxBlocks) break;
+
+				// w = Q_{j+1} B_{j+1}
+				DenseMatrixType r(k,k);
+				if (orthonormalize(w,r,j+1)==k) {
+					// the Krylov space is invariant, eigs are exact
+					converged = true;
+					break;
+				}
+
+				for (size_t a=0;a<k;a++) {
+					for (size_t b=0;b<k;b++) {
+						t((j+1)*k+a,j*k+b) = r(a,b);
+						t(j*k+a,(j+1)*k+b) = std::conj(r(b,a));
+					}
+				}
+				nblocks++;
+			}
+
+			ritzBlock(ritz,nblocks,ritzVectors);
+			if (converged || applied>=maxApplied) break;
+
+			// restart from the current approximations to the lowest k eigenvectors
+			BlockType& q = workspace_(0);
+			q = ritz;
+			DenseMatrixType r(k,k);
+			orthonormalize(q,r,0);
+		}
+
+		x = ritz;
+		eigs.resize(k);
+		std::ostringstream msg;
+		msg<<"Energy="<<eigs[0]<<" after applying the matrix to "<<applied<<" vectors";
+		msg<<" in blocks of "<<k;
+		if (!converged) msg<<" (not converged)";
+		progress_.printline(msg,std::cout);
+	}
+
+	// column 0 is initialVector, the others are random
+	void initialBlock(BlockType& q,const VectorType& initialVector)
+	{
+		size_t k = blockSize_;
+		q.resize(n_*k);
+		bool hasInitial = (initialVector.size()==n_);
+		for (size_t i=0;i<n_;i++) {
+			q[i*k] = (hasInitial) ? initialVector[i] : ComplexOrRealType(rng_()-0.5);
+			for (size_t v=1;v<k;v++) q[i*k+v] = rng_()-0.5;
+		}
+
+		DenseMatrixType r(k,k);
+		orthonormalize(q,r,0);
+	}
+
+	// the whole matrix, one block of unit vectors at a time, for a sector
+	// too small to hold two Krylov blocks
+	void computeLowestDense(std::vector<RealType>& eigs,BlockType& x)
+	{
+		size_t k = blockSize_;
+		DenseMatrixType h(n_,n_);
+		BlockType q(n_*k);
+		BlockType w(n_*k);
+		for (size_t start=0;start<n_;start+=k) {
+			std::fill(q.begin(),q.end(),ComplexOrRealType(0.0));
+			std::fill(w.begin(),w.end(),ComplexOrRealType(0.0));
+			for (size_t v=0;v<k && start+v<n_;v++) q[(start+v)*k+v] = 1.0;
+			mat_.matrixMatrixProduct(w,q,k);
+			for (size_t v=0;v<k && start+v<n_;v++)
+				for (size_t i=0;i<n_;i++) h(i,start+v) = w[i*k+v];
+		}
+
+		DenseMatrixType vecs;
+		diagonalise(eigs,vecs,h,n_);
+		x.resize(n_*k);
+		for (size_t i=0;i<n_;i++)
+			for (size_t c=0;c<k;c++) x[i*k+c] = vecs(i,c);
+
+		std::ostringstream msg;
+		msg<<"Energy="<<eigs[0]<<" by full diagonalization of a sector of size "<<n_;
+		progress_.printline(msg,std::cout);
+	}
+
+	// c = x^\dagger y
+	void innerProduct(DenseMatrixType& c,const BlockType& x,const BlockType& y) const
+	{
+		size_t k = blockSize_;
+		for (size_t a=0;a<k;a++)
+			for (size_t b=0;b<k;b++) c(a,b) = 0.0;
+
+		for (size_t i=0;i<n_;i++) {
+			const ComplexOrRealType* xi = &(x[i*k]);
+			const ComplexOrRealType* yi = &(y[i*k]);
+			for (size_t a=0;a<k;a++) {
+				ComplexOrRealType xia = std::conj(xi[a]);
+				for (size_t b=0;b<k;b++) c(a,b) += xia*yi[b];
+			}
+		}
+	}
+
+	// w -= x c
+	void subtract(BlockType& w,const BlockType& x,const DenseMatrixType& c) const
+	{
+		size_t k = blockSize_;
+		for (size_t i=0;i<n_;i++) {
+			ComplexOrRealType* wi = &(w[i*k]);
+			const ComplexOrRealType* xi = &(x[i*k]);
+			for (size_t a=0;a<k;a++)
+				for (size_t b=0;b<k;b++) wi[b] -= xi[a]*c(a,b);
+		}
+	}
+
+	// w = q r with q orthonormal and r upper triangular (modified Gram-Schmidt).
+	// A column of w that depends on the columns before it is replaced by a random
+	// vector orthogonal to them and to the first nprev Krylov blocks, and gets a
+	// zero diagonal in r, so that w = q r still holds; returns how many were replaced
+	size_t orthonormalize(BlockType& w,DenseMatrixType& r,size_t nprev)
+	{
+		size_t k = blockSize_;
+		size_t replaced = 0;
+		for (size_t b=0;b<k;b++) {
+			for (size_t a=0;a<k;a++) r(a,b) = 0.0;
+			RealType norm0 = columnNorm(w,b);
+			for (size_t a=0;a<b;a++) r(a,b) = removeProjection(w,b,w,a);
+
+			RealType norm = columnNorm(w,b);
+			if (norm<1e-10*norm0 || norm<1e-14) {
+				randomColumn(w,b,nprev);
+				replaced++;
+				continue;
+			}
+
+			r(b,b) = norm;
+			for (size_t i=0;i<n_;i++) w[i*k+b] /= norm;
+		}
+		return replaced;
+	}
+
+	// column b of w is set to a random unit vector orthogonal to its
+	// columns before b and to the first nprev Krylov blocks
+	void randomColumn(BlockType& w,size_t b,size_t nprev)
+	{
+		size_t k = blockSize_;
+		for (size_t i=0;i<n_;i++) w[i*k+b] = rng_()-0.5;
+		RealType norm0 = columnNorm(w,b);
+
+		// twice, so that the result is orthogonal to working precision
+		for (size_t pass=0;pass<2;pass++) {
+			for (size_t j=0;j<nprev;j++)
+				for (size_t a=0;a<k;a++) removeProjection(w,b,workspace_(j),a);
+			for (size_t a=0;a<b;a++) removeProjection(w,b,w,a);
+		}
+
+		RealType norm = columnNorm(w,b);
+		if (norm<1e-10*norm0) {
+			std::string s(__FILE__);
+			s += " no room left in the Krylov space for a deflated column\n";
+			throw std::runtime_error(s.c_str());
+		}
+		for (size_t i=0;i<n_;i++) w[i*k+b] /= norm;
+	}
+
+	// column b of w -= (column a of x) dot, with dot their inner product; returns dot
+	ComplexOrRealType removeProjection(BlockType& w,size_t b,const BlockType& x,size_t a) const
+	{
+		size_t k = blockSize_;
+		ComplexOrRealType dot = 0.0;
+		for (size_t i=0;i<n_;i++) dot += std::conj(x[i*k+a])*w[i*k+b];
+		for (size_t i=0;i<n_;i++) w[i*k+b] -= dot*x[i*k+a];
+		return dot;
+	}
+
+	RealType columnNorm(const BlockType& w,size_t b) const
+	{
+		RealType sum = 0;
+		for (size_t i=0;i<n_;i++) sum += std::real(std::conj(w[i*blockSize_+b])*w[i*blockSize_+b]);
+		return sqrt(sum);
+	}
+
+	// eigenpairs of the leading dim x dim part of t
+	void diagonalise(std::vector<RealType>& eigs,
+	                 DenseMatrixType& vecs,
+	                 const DenseMatrixType& t,
+	                 size_t dim) const
+	{
+		vecs = DenseMatrixType(dim,dim);
+		for (size_t a=0;a<dim;a++)
+			for (size_t b=0;b<dim;b++) vecs(a,b) = t(a,b);
+		eigs.resize(dim);
+		PsimagLite::diag(vecs,eigs,'V');
+	}
+
+	// x = first nblocks Krylov blocks times the first blockSize columns of vecs
+	void ritzBlock(BlockType& x,size_t nblocks,const DenseMatrixType& vecs) const
+	{
+		size_t k = blockSize_;
+		std::fill(x.begin(),x.end(),ComplexOrRealType(0.0));
+		for (size_t j=0;j<nblocks;j++) {
+			const BlockType& q = workspace_(j);
+			for (size_t i=0;i<n_;i++) {
+				for (size_t a=0;a<k;a++) {
+					ComplexOrRealType qia = q[i*k+a];
+					for (size_t c=0;c<k;c++) x[i*k+c] += qia*vecs(j*k+a,c);
+				}
+			}
+		}
+	}
+
+	MatrixType& mat_;
+	const ParametersForSolverType& params_;
+	size_t n_;
+	size_t blockSize_;
+	KrylovWorkspaceType ownWorkspace_;
+	KrylovWorkspaceType& workspace_;
+	PsimagLite::ProgressIndicator progress_;
+	PsimagLite::Random48<RealType> rng_;
+}; // class BlockLanczosSolver
+
+} // namespace Dmrg
+
+/*@}*/
+
+#endif // BLOCK_LANCZOS_SOLVER_H
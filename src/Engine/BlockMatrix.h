@@ -83,8 +83,12 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #define BLOCKMATRIX_HEADER_H
 #include <vector>
 #include <iostream>
+#include <limits>
+#include <algorithm>
 #include "Matrix.h" // in PsimagLite
 #include "Range.h"
+#include "PartialDiag.h"
+#include "ProgramGlobals.h"
 
 namespace Dmrg {
 
@@ -175,7 +179,7 @@ namespace Dmrg {
 		friend std::ostream &operator<<(std::ostream &s,BlockMatrix<S,MatrixInBlockTemplate2> const &A);
 		
 		template<typename S,typename Field,typename ConcurrencyTemplate>
-		friend void diagonalise(BlockMatrix<S,PsimagLite::Matrix<S> >  &C,std::vector<Field> &eigs,char option,ConcurrencyTemplate &concurrency);
+		friend void diagonaliseBlocks(BlockMatrix<S,PsimagLite::Matrix<S> >  &C,std::vector<Field> &eigs,char option,size_t kept,ConcurrencyTemplate &concurrency,size_t nthreads);
 		
 	private:
 		int rank_; //the rank of this matrix
@@ -263,35 +267,151 @@ namespace Dmrg {
 			enforcePhase(&(vpointer[i*a.n_row()]),a.n_row());
 	}
 
-	//! Parallel version of the diagonalization of a block diagonal matrix
+	//! Diagonalizes one block. If 0<kept<n only the kept largest eigenpairs
+	//! are computed, see diagonalisePartial
+	template<typename S,typename Field>
+	void diagonaliseBlock(PsimagLite::Matrix<S>& a,
+	                      std::vector<Field>& eigs,
+	                      char option,
+	                      size_t kept)
+	{
+		size_t n = a.n_row();
+		if (n<=kept || kept==0) {
+			PsimagLite::diag(a,eigs,option);
+		} else {
+			Field trace = 0;
+			for (size_t i=0;i<n;i++) trace += std::real(a(i,i));
+			partialDiag(a,eigs,kept);
+			for (size_t i=n-kept;i<n;i++) {
+				if (eigs[i]<0) eigs[i] = 0;
+				trace -= eigs[i];
+			}
+			if (trace<0) trace = 0;
+			Field leftOver = trace/(n-kept) + std::numeric_limits<Field>::min();
+			for (size_t i=0;i<n-kept;i++) eigs[i] = -leftOver;
+		}
+		enforcePhase(a);
+	}
+
+	//! Schedules the diagonalization of the blocks of one process over threads.
+	//! The cost of a block is taken as n^3. Blocks costing more than a thread's
+	//! fair share are done first, one at a time, by diagLargest(), so that a
+	//! threaded LAPACK can use all cores on them; the rest are packed into
+	//! one bin per thread, largest first into the least loaded bin
+	template<typename S,typename Field>
+	class ParallelBlockDiag {
+
+		typedef PsimagLite::Matrix<S> MatrixType;
+		typedef std::pair<double,size_t> PairType;
+
+	public:
+
+		ParallelBlockDiag(std::vector<MatrixType>& data,
+		                  std::vector<std::vector<Field> >& eigs,
+		                  const std::vector<size_t>& blocks,
+		                  char option,
+		                  size_t kept,
+		                  size_t nthreads)
+		: data_(data),eigs_(eigs),option_(option),kept_(kept),bins_(nthreads)
+		{
+			std::vector<PairType> costs;
+			double total = 0;
+			for (size_t i=0;i<blocks.size();i++) {
+				double n = data_[blocks[i]].n_row();
+				costs.push_back(PairType(n*n*n,blocks[i]));
+				total += n*n*n;
+			}
+			std::sort(costs.begin(),costs.end());
+
+			std::vector<double> load(nthreads,0);
+			for (size_t i=costs.size();i>0;i--) {
+				const PairType& p = costs[i-1];
+				if (nthreads>1 && p.first>total/nthreads) {
+					large_.push_back(p.second);
+					continue;
+				}
+				size_t bin = 0;
+				for (size_t t=1;t<nthreads;t++)
+					if (load[t]<load[bin]) bin = t;
+				bins_[bin].push_back(p.second);
+				load[bin] += p.first;
+			}
+		}
+
+		size_t bins() const { return bins_.size(); }
+
+		void diagLargest()
+		{
+			for (size_t i=0;i<large_.size();i++) diagOne(large_[i]);
+		}
+
+		void thread_function_(size_t threadNum,size_t blockSize,size_t total,pthread_mutex_t* myMutex)
+		{
+			for (size_t p=0;p<blockSize;p++) {
+				size_t ix = threadNum * blockSize + p;
+				if (ix>=total) break;
+				for (size_t i=0;i<bins_[ix].size();i++) diagOne(bins_[ix][i]);
+			}
+		}
+
+	private:
+
+		void diagOne(size_t m)
+		{
+			std::vector<Field> eigsTmp;
+			diagonaliseBlock(data_[m],eigsTmp,option_,kept_);
+			for (size_t j=0;j<eigs_[m].size();j++)
+				eigs_[m][j] = eigsTmp[j];
+		}
+
+		std::vector<MatrixType>& data_;
+		std::vector<std::vector<Field> >& eigs_;
+		char option_;
+		size_t kept_;
+		std::vector<size_t> large_;
+		std::vector<std::vector<size_t> > bins_;
+	}; // class ParallelBlockDiag
+
+	//! Diagonalizes all blocks of C: blocks are distributed over processes
+	//! with weights n^3, and within each process over nthreads threads with
+	//! ParallelBlockDiag. kept is as in diagonaliseBlock
 	template<typename S,typename Field,typename SomeConcurrencyType>
-	void diagonalise(BlockMatrix<S,PsimagLite::Matrix<S> >  &C,
-	                 std::vector<Field> &eigs,
-	                 char option,
-	                 SomeConcurrencyType &concurrency)
+	void diagonaliseBlocks(BlockMatrix<S,PsimagLite::Matrix<S> >  &C,
+	                       std::vector<Field> &eigs,
+	                       char option,
+	                       size_t kept,
+	                       SomeConcurrencyType &concurrency,
+	                       size_t nthreads)
 	{
-		std::vector<Field> eigsTmp;
+		typedef ParallelBlockDiag<S,Field> ParallelBlockDiagType;
+
 		std::vector<std::vector<Field> > eigsForGather;
 		std::vector<size_t> weights(C.blocks());
 
 		eigsForGather.resize(C.blocks());
 
 		for (size_t m=0;m<C.blocks();m++) {
-			eigsForGather[m].resize(C.offsets(m+1)-C.offsets(m));
-			weights[m] =  C.offsets(m+1)-C.offsets(m);
+			size_t n = C.offsets(m+1)-C.offsets(m);
+			eigsForGather[m].resize(n);
+			weights[m] = n*n*n;
 		}
 
 		eigs.resize(C.rank());
 
 		PsimagLite::Range<SomeConcurrencyType> range(0,C.blocks(),concurrency,weights);
 
-		for (;!range.end();range.next()) {
-			size_t m=range.index();
-			PsimagLite::diag(C.data_[m],eigsTmp,option);
-			enforcePhase(C.data_[m]);
-			for (int j=C.offsets(m);j< C.offsets(m+1);j++) 
-				eigsForGather[m][j-C.offsets(m)] = eigsTmp[j-C.offsets(m)];
-		}
+		std::vector<size_t> blocks;
+		for (;!range.end();range.next())
+			blocks.push_back(range.index());
+
+		if (nthreads==0) nthreads = 1;
+		ParallelBlockDiagType helper(C.data_,eigsForGather,blocks,option,kept,nthreads);
+		helper.diagLargest();
+
+		// range already split the blocks over processes
+		LOCAL_PTHREADS_NAME<ParallelBlockDiagType>::setThreads(nthreads);
+		LOCAL_PTHREADS_NAME<ParallelBlockDiagType> threadedDiag;
+		threadedDiag.loopCreate(helper.bins(),helper,concurrency);
 
 		concurrency.gather(C.data_);
 		concurrency.gather(eigsForGather);
@@ -305,6 +425,33 @@ namespace Dmrg {
 		concurrency.broadcast(C.data_);
 	}
 
+	//! Parallel version of the diagonalization of a block diagonal matrix
+	template<typename S,typename Field,typename SomeConcurrencyType>
+	void diagonalise(BlockMatrix<S,PsimagLite::Matrix<S> >  &C,
+	                 std::vector<Field> &eigs,
+	                 char option,
+	                 SomeConcurrencyType &concurrency,
+	                 size_t nthreads = 1)
+	{
+		diagonaliseBlocks(C,eigs,option,0,concurrency,nthreads);
+	}
+
+	//! Like diagonalise, with jobz='V', but only the min(kept,size) largest
+	//! eigenpairs of each block are computed, which contain the kept states of
+	//! the whole matrix. The eigenvectors not computed are zero; their
+	//! eigenvalues are set to minus the average of the block weight left over,
+	//! so that they sort below all computed ones and the discarded weight
+	//! (sum of absolute values) is unchanged
+	template<typename S,typename Field,typename SomeConcurrencyType>
+	void diagonalisePartial(BlockMatrix<S,PsimagLite::Matrix<S> >  &C,
+	                        std::vector<Field> &eigs,
+	                        size_t kept,
+	                        SomeConcurrencyType &concurrency,
+	                        size_t nthreads = 1)
+	{
+		diagonaliseBlocks(C,eigs,'V',kept,concurrency,nthreads);
+	}
+
 	template<class S,class MatrixInBlockTemplate>
 	bool isUnitary(BlockMatrix<S,MatrixInBlockTemplate> const &B)
 	{
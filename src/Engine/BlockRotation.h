@@ -0,0 +1,307 @@
+/*
+Copyright (c) 2012, UT-Battelle, LLC
+All rights reserved
+
+[DMRG++, Version 2.0.0]
+[by G.A., Oak Ridge National Laboratory]
+
+UT Battelle Open Source Software License 11242008
+
+OPEN SOURCE LICENSE
+
+Subject to the conditions of this License, each
+contributor to this software hereby grants, free of
+charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), a
+perpetual, worldwide, non-exclusive, no-charge,
+royalty-free, irrevocable copyright license to use, copy,
+modify, merge, publish, distribute, and/or sublicense
+copies of the Software.
+
+1. Redistributions of Software must retain the above
+copyright and license notices, this list of conditions,
+and the following disclaimer.  Changes or modifications
+to, or derivative works of, the Software should be noted
+with comments and the contributor and organization's
+name.
+
+2. Neither the names of UT-Battelle, LLC or the
+Department of Energy nor the names of the Software
+contributors may be used to endorse or promote products
+derived from this software without specific prior written
+permission of UT-Battelle.
+
+3. The software and the end-user documentation included
+with the redistribution, with or without modification,
+must include the following acknowledgment:
+
+"This product includes software produced by UT-Battelle,
+LLC under Contract No. DE-AC05-00OR22725  with the
+Department of Energy."
+
+*********************************************************
+DISCLAIMER
+
+THE SOFTWARE IS SUPPLIED BY THE COPYRIGHT HOLDERS AND
+CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER, CONTRIBUTORS, UNITED STATES GOVERNMENT,
+OR THE UNITED STATES DEPARTMENT OF ENERGY BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+DAMAGE.
+
+NEITHER THE UNITED STATES GOVERNMENT, NOR THE UNITED
+STATES DEPARTMENT OF ENERGY, NOR THE COPYRIGHT OWNER, NOR
+ANY OF THEIR EMPLOYEES, REPRESENTS THAT THE USE OF ANY
+INFORMATION, DATA, APPARATUS, PRODUCT, OR PROCESS
+DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
+
+*********************************************************
+
+
+*/
+// END LICENSE BLOCK
+/** \ingroup DMRG */
+/*@{*/
+
+/*! \file BlockRotation.h
+ *
+ *  Computes T^\dagger V T for a sparse transform T that is block diagonal,
+ *  as the one built from the density matrix, and sparse operators V.
+ *  The blocks of T are found from its sparsity pattern once, and stored
+ *  dense; each operator is then rotated with two GEMMs per pair of
+ *  blocks (a,b) it connects, without forming the conjugate transpose
+ *  of T again
+ *
+ */
+
+#ifndef BLOCK_ROTATION_H
+#define BLOCK_ROTATION_H
+
+#include <vector>
+#include <algorithm>
+#include "Matrix.h" // in PsimagLite
+#include "BLAS.h"
+
+namespace Dmrg {
+
+template<typename SparseMatrixType>
+class BlockRotation {
+
+	typedef typename SparseMatrixType::value_type ComplexOrRealType;
+	typedef PsimagLite::Matrix<ComplexOrRealType> MatrixType;
+	typedef std::pair<size_t,ComplexOrRealType> EntryType;
+
+	struct Group {
+		std::vector<size_t> rows;
+		std::vector<size_t> cols;
+		MatrixType t;
+	};
+
+public:
+
+	BlockRotation(const SparseMatrixType& ftransform)
+	: rows_(ftransform.row()),
+	  cols_(ftransform.col()),
+	  rowGroup_(rows_,-1),
+	  rowPos_(rows_,0)
+	{
+		// rows connected through a column of T belong to the same block
+		std::vector<size_t> parent(rows_);
+		for (size_t i=0;i<rows_;i++) parent[i] = i;
+		std::vector<int> firstRow(cols_,-1);
+		for (size_t i=0;i<rows_;i++) {
+			for (int k=ftransform.getRowPtr(i);k<ftransform.getRowPtr(i+1);k++) {
+				size_t j = ftransform.getCol(k);
+				if (firstRow[j]<0) {
+					firstRow[j] = i;
+					continue;
+				}
+				size_t r1 = findRoot(parent,i);
+				size_t r2 = findRoot(parent,firstRow[j]);
+				if (r1!=r2) parent[r1] = r2;
+			}
+		}
+
+		std::vector<int> groupOfRoot(rows_,-1);
+		for (size_t i=0;i<rows_;i++) {
+			if (ftransform.getRowPtr(i)==ftransform.getRowPtr(i+1)) continue;
+			size_t r = findRoot(parent,i);
+			if (groupOfRoot[r]<0) {
+				groupOfRoot[r] = groups_.size();
+				groups_.push_back(Group());
+			}
+			rowGroup_[i] = groupOfRoot[r];
+			Group& g = groups_[rowGroup_[i]];
+			rowPos_[i] = g.rows.size();
+			g.rows.push_back(i);
+		}
+
+		std::vector<size_t> colPos(cols_,0);
+		for (size_t j=0;j<cols_;j++) {
+			if (firstRow[j]<0) continue;
+			Group& g = groups_[rowGroup_[firstRow[j]]];
+			colPos[j] = g.cols.size();
+			g.cols.push_back(j);
+		}
+
+		for (size_t a=0;a<groups_.size();a++)
+			groups_[a].t = MatrixType(groups_[a].rows.size(),groups_[a].cols.size());
+
+		for (size_t i=0;i<rows_;i++) {
+			if (rowGroup_[i]<0) continue;
+			Group& g = groups_[rowGroup_[i]];
+			for (int k=ftransform.getRowPtr(i);k<ftransform.getRowPtr(i+1);k++) {
+				size_t j = ftransform.getCol(k);
+				g.t(rowPos_[i],colPos[j]) = ftransform.getValue(k);
+			}
+		}
+	}
+
+	//! v = T^\dagger v T
+	void operator()(SparseMatrixType& v) const
+	{
+		if (v.row()==0) return;
+
+		std::vector<std::vector<EntryType> > result(cols_);
+		std::vector<int> denseIndex(groups_.size(),-1);
+		std::vector<size_t> touched;
+		std::vector<MatrixType> vab;
+		MatrixType x;
+		MatrixType w;
+		ComplexOrRealType one = 1.0;
+		ComplexOrRealType zero = 0.0;
+
+		for (size_t a=0;a<groups_.size();a++) {
+			const Group& ga = groups_[a];
+			if (ga.cols.size()==0) continue;
+
+			// gather the dense blocks v(R_a,R_b) for all b connected to a
+			touched.clear();
+			for (size_t p=0;p<ga.rows.size();p++) {
+				size_t i = ga.rows[p];
+				for (int k=v.getRowPtr(i);k<v.getRowPtr(i+1);k++) {
+					int b = rowGroup_[v.getCol(k)];
+					if (b<0 || denseIndex[b]>=0) continue;
+					denseIndex[b] = touched.size();
+					touched.push_back(b);
+				}
+			}
+			vab.resize(touched.size());
+			for (size_t q=0;q<touched.size();q++) {
+				vab[q] = MatrixType(ga.rows.size(),groups_[touched[q]].rows.size());
+			}
+			for (size_t p=0;p<ga.rows.size();p++) {
+				size_t i = ga.rows[p];
+				for (int k=v.getRowPtr(i);k<v.getRowPtr(i+1);k++) {
+					size_t j = v.getCol(k);
+					int b = rowGroup_[j];
+					if (b<0) continue;
+					vab[denseIndex[b]](p,rowPos_[j]) += v.getValue(k);
+				}
+			}
+
+			// T_a^\dagger v(R_a,R_b) T_b
+			for (size_t q=0;q<touched.size();q++) {
+				const Group& gb = groups_[touched[q]];
+				denseIndex[touched[q]] = -1;
+				if (gb.cols.size()==0) continue;
+				int ra = ga.rows.size();
+				int rb = gb.rows.size();
+				int ca = ga.cols.size();
+				int cb = gb.cols.size();
+				x.reset(ra,cb);
+				w.reset(ca,cb);
+				psimag::BLAS::GEMM('N','N',ra,cb,rb,one,&(vab[q](0,0)),ra,
+						   &(gb.t(0,0)),rb,zero,&(x(0,0)),ra);
+				psimag::BLAS::GEMM('C','N',ca,cb,ra,one,&(ga.t(0,0)),ra,
+						   &(x(0,0)),ra,zero,&(w(0,0)),ca);
+				for (int p=0;p<ca;p++) {
+					std::vector<EntryType>& row = result[ga.cols[p]];
+					for (int r=0;r<cb;r++) {
+						if (w(p,r)==static_cast<ComplexOrRealType>(0.0)) continue;
+						row.push_back(EntryType(gb.cols[r],w(p,r)));
+					}
+				}
+			}
+		}
+
+		v.resize(cols_,cols_);
+		size_t counter = 0;
+		for (size_t i=0;i<cols_;i++) {
+			v.setRow(i,counter);
+			std::vector<EntryType>& row = result[i];
+			std::sort(row.begin(),row.end(),lessCol);
+			for (size_t k=0;k<row.size();k++) {
+				v.pushCol(row[k].first);
+				v.pushValue(row[k].second);
+				counter++;
+			}
+		}
+		v.setRow(cols_,counter);
+		v.checkValidity();
+	}
+
+private:
+
+	static bool lessCol(const EntryType& e1,const EntryType& e2)
+	{
+		return (e1.first<e2.first);
+	}
+
+	static size_t findRoot(std::vector<size_t>& parent,size_t i)
+	{
+		while (parent[i]!=i) {
+			parent[i] = parent[parent[i]];
+			i = parent[i];
+		}
+		return i;
+	}
+
+	size_t rows_;
+	size_t cols_;
+	std::vector<int> rowGroup_;
+	std::vector<size_t> rowPos_;
+	std::vector<Group> groups_;
+}; // class BlockRotation
+
+//! Rotates the operators with the given indices, distributed over threads
+template<typename BlockRotationType,typename OperatorType>
+class ParallelBlockRotation {
+
+public:
+
+	ParallelBlockRotation(const BlockRotationType& rotation,
+			      std::vector<OperatorType>& operators,
+			      const std::vector<size_t>& indices)
+	: rotation_(rotation),operators_(operators),indices_(indices)
+	{}
+
+	void thread_function_(size_t threadNum,size_t blockSize,size_t total,pthread_mutex_t* myMutex)
+	{
+		for (size_t p=0;p<blockSize;p++) {
+			size_t ix = threadNum * blockSize + p;
+			if (ix>=total) break;
+			rotation_(operators_[indices_[ix]].data);
+		}
+	}
+
+private:
+
+	const BlockRotationType& rotation_;
+	std::vector<OperatorType>& operators_;
+	const std::vector<size_t>& indices_;
+}; // class ParallelBlockRotation
+} // namespace Dmrg
+
+/*@}*/
+#endif // BLOCK_ROTATION_H
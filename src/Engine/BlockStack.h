@@ -0,0 +1,267 @@
+/*
+Copyright (c) 2012, UT-Battelle, LLC
+All rights reserved
+
+[DMRG++, Version 2.0.0]
+[by G.A., Oak Ridge National Laboratory]
+
+UT Battelle Open Source Software License 11242008
+
+OPEN SOURCE LICENSE
+
+Subject to the conditions of this License, each
+contributor to this software hereby grants, free of
+charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), a
+perpetual, worldwide, non-exclusive, no-charge,
+royalty-free, irrevocable copyright license to use, copy,
+modify, merge, publish, distribute, and/or sublicense
+copies of the Software.
+
+1. Redistributions of Software must retain the above
+copyright and license notices, this list of conditions,
+and the following disclaimer.  Changes or modifications
+to, or derivative works of, the Software should be noted
+with comments and the contributor and organization's
+name.
+
+2. Neither the names of UT-Battelle, LLC or the
+Department of Energy nor the names of the Software
+contributors may be used to endorse or promote products
+derived from this software without specific prior written
+permission of UT-Battelle.
+
+3. The software and the end-user documentation included
+with the redistribution, with or without modification,
+must include the following acknowledgment:
+
+"This product includes software produced by UT-Battelle,
+LLC under Contract No. DE-AC05-00OR22725  with the
+Department of Energy."
+
+*********************************************************
+DISCLAIMER
+
+THE SOFTWARE IS SUPPLIED BY THE COPYRIGHT HOLDERS AND
+CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER, CONTRIBUTORS, UNITED STATES GOVERNMENT,
+OR THE UNITED STATES DEPARTMENT OF ENERGY BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+DAMAGE.
+
+NEITHER THE UNITED STATES GOVERNMENT, NOR THE UNITED
+STATES DEPARTMENT OF ENERGY, NOR THE COPYRIGHT OWNER, NOR
+ANY OF THEIR EMPLOYEES, REPRESENTS THAT THE USE OF ANY
+INFORMATION, DATA, APPARATUS, PRODUCT, OR PROCESS
+DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
+
+*********************************************************
+
+
+*/
+// END LICENSE BLOCK
+/** \ingroup DMRG */
+/*@{*/
+/*! \file BlockStack.h
+ *
+ *  A stack of grown blocks, similar to std::stack, that keeps at most
+ *  window blocks in memory; older blocks are written to scratch files,
+ *  one per block. The stack is only ever popped one block at a time,
+ *  so the block needed next is always the one below the top: when
+ *  a pop leaves one block in memory, the highest block on disk is
+ *  read back on a background thread (with USE_PTHREADS), while
+ *  the caller uses the top.
+ *
+ *  A window of 0 keeps all blocks in memory
+ *
+ */
+
+#ifndef BLOCK_STACK_H
+#define BLOCK_STACK_H
+
+#include <deque>
+#include <string>
+#include <cstdio>
+#include <cassert>
+#include <stdexcept>
+#include "IoSimple.h" // in PsimagLite
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#endif
+
+namespace Dmrg {
+
+template<typename DataType>
+class BlockStack {
+
+	typedef PsimagLite::IoSimple::In IoInType;
+	typedef PsimagLite::IoSimple::Out IoOutType;
+
+public:
+
+	BlockStack(size_t window,const std::string& scratch,size_t rank=0)
+	: window_(window),
+	  scratch_(scratch + ttos(rank) + "_"),
+	  spilled_(0),
+	  prefetching_(false),
+	  prefetched_(0)
+	{}
+
+	~BlockStack()
+	{
+		// must not throw: a failed prefetch only leaves its file to remove
+		joinPrefetch();
+		delete prefetched_;
+		for (size_t i=0;i<mem_.size();i++) delete mem_[i];
+		for (size_t i=0;i<spilled_;i++) remove(fileName(i).c_str());
+	}
+
+	void push(const DataType& d)
+	{
+		waitForPrefetch();
+		mem_.push_back(new DataType(d));
+		if (window_==0 || mem_.size()<=window_) return;
+
+		// the oldest block in memory goes to disk
+		DataType* oldest = mem_.front();
+		IoOutType io;
+		io.open(fileName(spilled_),std::ios_base::trunc,0);
+		oldest->save(io);
+		io.close();
+		delete oldest;
+		mem_.pop_front();
+		spilled_++;
+	}
+
+	void pop()
+	{
+		if (mem_.size()==0) waitOrLoad();
+		delete mem_.back();
+		mem_.pop_back();
+		if (mem_.size()<2 && spilled_>0) startPrefetch();
+	}
+
+	DataType& top()
+	{
+		if (mem_.size()==0) waitOrLoad();
+		return *mem_.back();
+	}
+
+	size_t size() const { return spilled_ + mem_.size(); }
+
+private:
+
+	BlockStack(const BlockStack&);
+
+	BlockStack& operator=(const BlockStack&);
+
+	std::string fileName(size_t i) const
+	{
+		return scratch_ + ttos(i);
+	}
+
+	static DataType* load(const std::string& file)
+	{
+		IoInType io(file);
+		DataType* d = new DataType(io,"",0);
+		io.close();
+		return d;
+	}
+
+	//! the highest block on disk becomes the lowest in memory
+	void restore(DataType* d)
+	{
+		assert(spilled_>0);
+		spilled_--;
+		remove(fileName(spilled_).c_str());
+		mem_.push_front(d);
+	}
+
+	void waitOrLoad()
+	{
+		if (prefetching_) {
+			waitForPrefetch();
+			return;
+		}
+		if (spilled_==0) {
+			std::string s(__FILE__);
+			s += ": top or pop of an empty stack\n";
+			throw std::runtime_error(s.c_str());
+		}
+		restore(load(fileName(spilled_-1)));
+	}
+
+	void startPrefetch()
+	{
+#ifdef USE_PTHREADS
+		if (prefetching_) return;
+		prefetchFile_ = fileName(spilled_-1);
+		prefetchError_ = "";
+		prefetched_ = 0;
+		int ret = pthread_create(&thread_,0,prefetchThread,this);
+		// without a thread the block is read when needed
+		prefetching_ = (ret==0);
+#endif
+	}
+
+	void joinPrefetch()
+	{
+#ifdef USE_PTHREADS
+		if (!prefetching_) return;
+		pthread_join(thread_,0);
+		prefetching_ = false;
+#endif
+	}
+
+	void waitForPrefetch()
+	{
+#ifdef USE_PTHREADS
+		if (!prefetching_) return;
+		joinPrefetch();
+		if (!prefetched_) {
+			std::string s(__FILE__);
+			s += ": reading " + prefetchFile_ + " failed: " + prefetchError_ + "\n";
+			throw std::runtime_error(s.c_str());
+		}
+		restore(prefetched_);
+		prefetched_ = 0;
+#endif
+	}
+
+#ifdef USE_PTHREADS
+	static void* prefetchThread(void* arg)
+	{
+		BlockStack* stack = static_cast<BlockStack*>(arg);
+		try {
+			stack->prefetched_ = load(stack->prefetchFile_);
+		} catch (std::exception& e) {
+			stack->prefetchError_ = e.what();
+		}
+		return 0;
+	}
+
+	pthread_t thread_;
+#endif
+	size_t window_;
+	std::string scratch_;
+	size_t spilled_;
+	bool prefetching_;
+	DataType* prefetched_;
+	std::string prefetchFile_;
+	std::string prefetchError_;
+	std::deque<DataType*> mem_;
+}; // class BlockStack
+} // namespace Dmrg
+
+/*@}*/
+#endif // BLOCK_STACK_H
@@ -83,6 +83,7 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 
 #include <stack>
 #include "DiskStack.h"
+#include "BlockStack.h"
 #include "ProgressIndicator.h"
 #include "ProgramGlobals.h"
 
@@ -95,7 +96,7 @@ namespace Dmrg {
 		typedef typename TargettingType::BasisWithOperatorsType BasisWithOperatorsType;
 		typedef typename BasisWithOperatorsType::OperatorsType OperatorsType;
 		typedef typename TargettingType::IoType IoType;
-		typedef std::stack<BasisWithOperatorsType> MemoryStackType;
+		typedef BlockStack<BasisWithOperatorsType> MemoryStackType;
 		typedef DiskStack<BasisWithOperatorsType>  DiskStackType;
 
 		const std::string SYSTEM_STACK_STRING;
@@ -106,8 +107,10 @@ namespace Dmrg {
 			ENVIRON_STACK_STRING("EnvironStack"),
 			parameters_(parameters),
 			enabled_(parameters_.options.find("checkpoint")!=std::string::npos || parameters_.options.find("restart")!=std::string::npos),
-			systemDisk_(SYSTEM_STACK_STRING+parameters_.checkpoint.filename , SYSTEM_STACK_STRING+parameters_.filename,enabled_,rank),
-			envDisk_(ENVIRON_STACK_STRING+parameters_.checkpoint.filename , ENVIRON_STACK_STRING+parameters_.filename,enabled_,rank),
+			systemStack_(parameters_.blockStackWindow,appendWithDir(SYSTEM_STACK_STRING+"Scratch",parameters_.filename),rank),
+			envStack_(parameters_.blockStackWindow,appendWithDir(ENVIRON_STACK_STRING+"Scratch",parameters_.filename),rank),
+			systemDisk_(SYSTEM_STACK_STRING+parameters_.checkpoint.filename , SYSTEM_STACK_STRING+parameters_.filename,enabled_,rank,binaryStacks()),
+			envDisk_(ENVIRON_STACK_STRING+parameters_.checkpoint.filename , ENVIRON_STACK_STRING+parameters_.filename,enabled_,rank,binaryStacks()),
 			progress_("Checkpoint",rank)
 		{
 			if (!enabled_) return;
@@ -163,7 +166,8 @@ namespace Dmrg {
 			else systemStack_.push(pSorE);
 		}
 
-		BasisWithOperatorsType shrink(size_t what,const TargettingType& target)
+		//! Returns a reference to the top of the stack, valid until the next push or shrink
+		BasisWithOperatorsType& shrink(size_t what,const TargettingType& target)
 		{
 			if (what==ProgramGlobals::ENVIRON) return shrink(envStack_,target);
 			else return shrink(systemStack_,target);
@@ -180,7 +184,7 @@ namespace Dmrg {
 	private:
 
 		//! shrink  (we don't really shrink, we just undo the growth)
-		BasisWithOperatorsType shrink(MemoryStackType& thisStack,const TargettingType& target)
+		BasisWithOperatorsType& shrink(MemoryStackType& thisStack,const TargettingType& target)
 		{
 			thisStack.pop();
 			BasisWithOperatorsType& basisWithOps =  thisStack.top();
@@ -219,7 +223,11 @@ namespace Dmrg {
 
 		}
 
-		//! Move elsewhere
+		bool binaryStacks() const
+		{
+			return (parameters_.options.find("binaryStacks")!=std::string::npos);
+		}
+
 		//! returns s1+s2 if s2 has no '/',
 		//! if s2 = s2a + '/' + s2b return s2a + '/' + s1 + s2b
 		std::string appendWithDir(const std::string& s1,const std::string& s2) const
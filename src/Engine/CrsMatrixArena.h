@@ -0,0 +1,219 @@
+/*
+Copyright (c) 2012, UT-Battelle, LLC
+All rights reserved
+
+[DMRG++, Version 2.0.0]
+[by G.A., Oak Ridge National Laboratory]
+
+UT Battelle Open Source Software License 11242008
+
+OPEN SOURCE LICENSE
+
+Subject to the conditions of this License, each
+contributor to this software hereby grants, free of
+charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), a
+perpetual, worldwide, non-exclusive, no-charge,
+royalty-free, irrevocable copyright license to use, copy,
+modify, merge, publish, distribute, and/or sublicense
+copies of the Software.
+
+1. Redistributions of Software must retain the above
+copyright and license notices, this list of conditions,
+and the following disclaimer.  Changes or modifications
+to, or derivative works of, the Software should be noted
+with comments and the contributor and organization's
+name.
+
+2. Neither the names of UT-Battelle, LLC or the
+Department of Energy nor the names of the Software
+contributors may be used to endorse or promote products
+derived from this software without specific prior written
+permission of UT-Battelle.
+
+3. The software and the end-user documentation included
+with the redistribution, with or without modification,
+must include the following acknowledgment:
+
+"This product includes software produced by UT-Battelle,
+LLC under Contract No. DE-AC05-00OR22725  with the
+Department of Energy."
+
+*********************************************************
+DISCLAIMER
+
+THE SOFTWARE IS SUPPLIED BY THE COPYRIGHT HOLDERS AND
+CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER, CONTRIBUTORS, UNITED STATES GOVERNMENT,
+OR THE UNITED STATES DEPARTMENT OF ENERGY BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+DAMAGE.
+
+NEITHER THE UNITED STATES GOVERNMENT, NOR THE UNITED
+STATES DEPARTMENT OF ENERGY, NOR THE COPYRIGHT OWNER, NOR
+ANY OF THEIR EMPLOYEES, REPRESENTS THAT THE USE OF ANY
+INFORMATION, DATA, APPARATUS, PRODUCT, OR PROCESS
+DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
+
+*********************************************************
+
+
+*/
+// END LICENSE BLOCK
+/** \ingroup DMRG */
+/*@{*/
+/*! \file CrsMatrixArena.h
+ *
+ *  A pool of sparse matrices for the temporaries of a DMRG step.
+ *  Matrices handed out keep the storage of their row pointer, column
+ *  and value arrays from previous uses, so that building a temporary
+ *  reuses memory instead of going back to malloc.
+ *  DmrgSolver calls reset() at the end of each step of a finite loop;
+ *  matrices beyond the largest number in use at once during the step
+ *  are then freed, so the pool follows the working set of the run.
+ *
+ *  Use ArenaMatrix below to borrow a matrix for a scope
+ *
+ */
+
+#ifndef CRS_MATRIX_ARENA_H
+#define CRS_MATRIX_ARENA_H
+
+#include <vector>
+#include <cassert>
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#endif
+
+namespace Dmrg {
+
+template<typename SparseMatrixType>
+class CrsMatrixArena {
+
+public:
+
+	static SparseMatrixType* acquire()
+	{
+		lock();
+		SparseMatrixType* m = 0;
+		if (free_.size()>0) {
+			m = free_.back();
+			free_.pop_back();
+		}
+		inUse_++;
+		if (inUse_>highWater_) highWater_ = inUse_;
+		unlock();
+		if (!m) m = new SparseMatrixType();
+		return m;
+	}
+
+	static void release(SparseMatrixType* m)
+	{
+		lock();
+		assert(inUse_>0);
+		inUse_--;
+		free_.push_back(m);
+		unlock();
+	}
+
+	//! End of a step: frees matrices not needed by the last step
+	static void reset()
+	{
+		lock();
+		size_t keep = (highWater_>inUse_) ? highWater_ - inUse_ : 0;
+		while (free_.size()>keep) {
+			delete free_.back();
+			free_.pop_back();
+		}
+		highWater_ = inUse_;
+		unlock();
+	}
+
+	//! number of matrices held, in use or free
+	static size_t size()
+	{
+		lock();
+		size_t n = inUse_ + free_.size();
+		unlock();
+		return n;
+	}
+
+private:
+
+	static void lock()
+	{
+#ifdef USE_PTHREADS
+		pthread_mutex_lock(&mutex_);
+#endif
+	}
+
+	static void unlock()
+	{
+#ifdef USE_PTHREADS
+		pthread_mutex_unlock(&mutex_);
+#endif
+	}
+
+	static std::vector<SparseMatrixType*> free_;
+	static size_t inUse_;
+	static size_t highWater_;
+#ifdef USE_PTHREADS
+	static pthread_mutex_t mutex_;
+#endif
+}; // class CrsMatrixArena
+
+template<typename SparseMatrixType>
+std::vector<SparseMatrixType*> CrsMatrixArena<SparseMatrixType>::free_;
+
+template<typename SparseMatrixType>
+size_t CrsMatrixArena<SparseMatrixType>::inUse_ = 0;
+
+template<typename SparseMatrixType>
+size_t CrsMatrixArena<SparseMatrixType>::highWater_ = 0;
+
+#ifdef USE_PTHREADS
+template<typename SparseMatrixType>
+pthread_mutex_t CrsMatrixArena<SparseMatrixType>::mutex_ = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+//! A matrix borrowed from the arena for the lifetime of this object
+template<typename SparseMatrixType>
+class ArenaMatrix {
+
+	typedef CrsMatrixArena<SparseMatrixType> ArenaType;
+
+public:
+
+	ArenaMatrix() : m_(ArenaType::acquire()) {}
+
+	~ArenaMatrix()
+	{
+		ArenaType::release(m_);
+	}
+
+	SparseMatrixType& operator()() { return *m_; }
+
+	const SparseMatrixType& operator()() const { return *m_; }
+
+private:
+
+	ArenaMatrix(const ArenaMatrix&);
+
+	ArenaMatrix& operator=(const ArenaMatrix&);
+
+	SparseMatrixType* m_;
+}; // class ArenaMatrix
+} // namespace Dmrg
+
+/*@}*/
+#endif // CRS_MATRIX_ARENA_H
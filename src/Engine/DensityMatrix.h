@@ -165,6 +165,19 @@ namespace Dmrg {
 			}
 		}
 
+		//! Computes the eigenvectors, but only those that can be among the
+		//! kept largest ones; see diagonalisePartial. Full diag for SU(2)
+		template<typename ConcurrencyType>
+		void diagPartial(std::vector<RealType>& eigs,size_t kept,
+				ConcurrencyType& concurrency)
+		{
+			if (!DmrgBasisType::useSu2Symmetry()) {
+				densityMatrixLocal_.diagPartial(eigs,kept,concurrency);
+			} else {
+				densityMatrixSu2_.diag(eigs,'V',concurrency);
+			}
+		}
+
 		template<
 			typename RealType_,
 			typename DmrgBasisType_,
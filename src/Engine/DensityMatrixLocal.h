@@ -76,7 +76,6 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "BlockMatrix.h"
 #include "DensityMatrixBase.h"
 #include "ParallelDensityMatrix.h"
-#include "NoPthreads.h"
 
 namespace Dmrg {
 	//!
@@ -114,7 +113,8 @@ namespace Dmrg {
 			progress_("DensityMatrixLocal",parallelRank_),
 			data_(pBasis.size(),
 			pBasis.partition()-1),
-			debug_(debug),verbose_(verbose)
+			debug_(debug),verbose_(verbose),
+			nthreads_(target.model().params().nthreads)
 		{
 		}
 
@@ -137,7 +137,13 @@ namespace Dmrg {
 		template<typename ConcurrencyType>
 		void diag(std::vector<RealType>& eigs,char jobz,ConcurrencyType& concurrency)
 		{
-			diagonalise<DensityMatrixElementType,RealType,ConcurrencyType>(data_,eigs,jobz,concurrency);
+			diagonalise<DensityMatrixElementType,RealType,ConcurrencyType>(data_,eigs,jobz,concurrency,nthreads_);
+		}
+
+		template<typename ConcurrencyType>
+		void diagPartial(std::vector<RealType>& eigs,size_t kept,ConcurrencyType& concurrency)
+		{
+			diagonalisePartial<DensityMatrixElementType,RealType,ConcurrencyType>(data_,eigs,kept,concurrency,nthreads_);
 		}
 
 		virtual void init(
@@ -153,46 +159,24 @@ namespace Dmrg {
 				msg<<"Init partition for all targets";
 				progress_.printline(msg,std::cout);
 			}
-			//loop over all partitions:
-			for (size_t m=0;m<pBasis.partition()-1;m++) {
-				// size of this partition
-				size_t bs = pBasis.partition(m+1)-pBasis.partition(m);
-				
-				// density matrix block for this partition:
-				BuildingBlockType matrixBlock(bs,bs);
-				
-				// weight of the ground state:
-				RealType w = target.gsWeight();
-				
-				// if we are to target the ground state do it now:
-				ParallelDensityMatrixType helperDm(target,pBasis,pBasisSummed,pSE,direction,m,matrixBlock);
-
-				if (target.includeGroundStage())
-					helperDm.initPartition(matrixBlock,pBasis,m,target.gs(),
-							pBasisSummed,pSE,direction,w);
-				
-				// target all other states if any:
-				if (target.size()>0) {
-
-					PsimagLite::NoPthreads<ParallelDensityMatrixType> threadedDm;
-					PsimagLite::NoPthreads<ParallelDensityMatrixType>::setThreads(target.model().params().nthreads);
-					if (threadedDm.name()=="pthreads") {
-						std::ostringstream msg;
-						msg<<"Threading with "<<threadedDm.threads();
-						progress_.printline(msg,std::cout);
-					}
-
-					threadedDm.loopCreate(target.size(),helperDm,target.model().concurrency());
-
-//					for (size_t i=0;i<target.size();i++) {
-//						w = target.weight(i)/target.normSquared(i);
-//						initPartition(matrixBlock,pBasis,m,target(i),
-//						              pBasisSummed,pSE,direction,w);
-//					}
-				}
-				// set this matrix block into data_
-				data_.setBlock(m,pBasis.partition(m),matrixBlock);
+			// reduce() only sums the partials of this process, so all the pairs
+			// are done by the threads of each process
+			typedef LOCAL_PTHREADS_NAME<ParallelDensityMatrixType> ParallelizerType;
+			ParallelizerType::setThreads(target.model().params().nthreads);
+			ParallelizerType threadedDm;
+			if (threadedDm.name()=="pthreads") {
+				std::ostringstream msg;
+				msg<<"Threading with "<<threadedDm.threads();
+				progress_.printline(msg,std::cout);
 			}
+
+			// distribute the pairs (partition, target) over threads
+			ParallelDensityMatrixType helperDm(target,pBasis,pBasisSummed,pSE,direction,
+							   threadedDm.threads());
+			threadedDm.loopCreate(helperDm.size(),helperDm,target.model().concurrency());
+
+			// set the blocks into data_
+			helperDm.reduce(data_);
 			{
 				std::ostringstream msg;
 				msg<<"Done with init partition";
@@ -215,6 +199,7 @@ namespace Dmrg {
 		ProgressIndicatorType progress_;
 		BlockMatrixType data_;
 		bool debug_,verbose_;
+		size_t nthreads_;
 
 	}; // class DensityMatrixLocal
 
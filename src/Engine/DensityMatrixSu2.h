@@ -111,7 +111,8 @@ namespace Dmrg {
 			const DmrgBasisWithOperatorsType& pBasisSummed,
 			const DmrgBasisType& pSE,
 			size_t direction,bool debug=false,bool verbose=false) : data_(pBasis.size() ,pBasis.partition()-1),mMaximal_(pBasis.partition()-1),pBasis_(pBasis),
-				debug_(debug),verbose_(verbose)
+				debug_(debug),verbose_(verbose),
+				nthreads_(target.model().params().nthreads)
 		{
 		}
 		
@@ -154,7 +155,7 @@ namespace Dmrg {
 		template<typename ConcurrencyType>
 		void diag(std::vector<RealType>& eigs,char jobz,ConcurrencyType& concurrency)
 		{
-			diagonalise<DensityMatrixElementType,RealType,ConcurrencyType>(data_,eigs,jobz,concurrency);
+			diagonalise<DensityMatrixElementType,RealType,ConcurrencyType>(data_,eigs,jobz,concurrency,nthreads_);
 			
 			//make sure non-maximals are equal to maximals
 			// this is needed because otherwise there's no assure that m-independence
@@ -228,6 +229,7 @@ namespace Dmrg {
 		std::vector<size_t> mMaximal_;
 		const DmrgBasisWithOperatorsType& pBasis_;
 		bool debug_,verbose_;
+		size_t nthreads_;
 		
 		size_t findMaximalPartition(size_t p,DmrgBasisWithOperatorsType const &pBasis)
 		{
@@ -85,6 +85,7 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "ProgramGlobals.h"
 #include "LanczosSolver.h"
 #include "DavidsonSolver.h"
+#include "BlockLanczosSolver.h"
 #include "ParametersForSolver.h"
 
 namespace Dmrg {
@@ -111,6 +112,7 @@ namespace Dmrg {
 		typedef typename ModelType::ModelHelperType ModelHelperType;
 		typedef typename ModelHelperType::LeftRightSuperType LeftRightSuperType;
 		typedef typename ModelType::ReflectionSymmetryType ReflectionSymmetryType;
+		typedef KrylovWorkspace<typename TargetVectorType::value_type> KrylovWorkspaceType;
 
 		Diagonalization(const ParametersType& parameters,
                         const ModelType& model,
@@ -129,9 +131,14 @@ namespace Dmrg {
 		  progress_("Diag.",0),
 		  quantumSector_(quantumSector),
 		  wft_(waveFunctionTransformation),
-		  oldEnergy_(0)
+		  oldEnergy_(0),
+		  truncationError_(0),
+		  lanczosEps_(parameters.lanczosEps)
 		{}
 
+		//! The discarded weight of the last truncation, used by adaptiveLanczosEps
+		void setTruncationError(const RealType& error) { truncationError_ = error; }
+
 		//!PTEX_LABEL{Diagonalization}
 		RealType operator()(TargettingType& target,
 		                    size_t direction,
@@ -200,6 +207,8 @@ namespace Dmrg {
 		
 			if (!target.includeGroundStage()) return gsEnergy;
 
+			lanczosEps_ = lanczosTolerance(direction,loopIndex);
+
 			std::ostringstream msg0;
 			msg0<<"Setting up Hamiltonian basis of size="<<lrs.super().size();
 			progress_.printline(msg0,std::cout);
@@ -311,6 +320,34 @@ namespace Dmrg {
 			return gsEnergy;
 		}
 
+		//! With the option adaptiveLanczosEps, the tolerance of the eigensolver follows
+		//! the discarded weight of the previous step: it is AdaptiveFactor times
+		//! that weight, but not below LanczosEps nor above MaxAdaptiveEps.
+		//! The last finite loop and any finite loop saving data to disk use LanczosEps
+		RealType lanczosTolerance(size_t direction,size_t loopIndex) const
+		{
+			static const RealType AdaptiveFactor = 0.01;
+			static const RealType MaxAdaptiveEps = 1e-6;
+
+			RealType eps = parameters_.lanczosEps;
+			if (parameters_.options.find("adaptiveLanczosEps")==std::string::npos)
+				return eps;
+
+			if (direction!=WaveFunctionTransfType::INFINITE) {
+				if (loopIndex+1==parameters_.finiteLoop.size()) return eps;
+				if (parameters_.finiteLoop[loopIndex].saveOption & 1) return eps;
+			}
+
+			RealType adaptive = AdaptiveFactor * truncationError_;
+			if (adaptive>MaxAdaptiveEps) adaptive = MaxAdaptiveEps;
+			if (adaptive<eps) return eps;
+
+			std::ostringstream msg;
+			msg<<"Eigensolver tolerance="<<adaptive<<" for truncation error="<<truncationError_;
+			progress_.printline(msg,std::cout);
+			return adaptive;
+		}
+
 		/** Diagonalise the i-th block of the matrix, return its eigenvectors 
 		    in tmpVec and its eigenvalues in energyTmp
 		!PTEX_LABEL{diagonaliseOneBlock} */
@@ -377,11 +414,24 @@ namespace Dmrg {
 
 			ParametersForSolverType params;
 			params.steps = parameters_.lanczosSteps;
-			params.tolerance = parameters_.lanczosEps;
+			params.tolerance = lanczosEps_;
 			params.stepsForEnergyConvergence =ProgramGlobals::MaxLanczosSteps;
 			params.options= parameters_.options;
 			params.lotaMemory=false; //!(parameters_.options.find("DoNotSaveLanczosVectors")!=std::string::npos);
 
+			bool useBlockLanczos = (parameters_.options.find("useBlockLanczos")!=std::string::npos);
+			if (useBlockLanczos && !reflectionOperator_.isEnabled()) {
+				if (lanczosHelper.rank()==0) {
+					energyTmp=10000;
+					return;
+				}
+				BlockLanczosSolver<ParametersForSolverType,MyInternalProduct,SomeVectorType>
+				        blockLanczos(lanczosHelper,params,parameters_.lanczosBlockSize,&krylovWorkspace_);
+				tmpVec.resize(lanczosHelper.rank());
+				blockLanczos.computeGroundState(energyTmp,tmpVec,initialVector);
+				return;
+			}
+
 			LanczosOrDavidsonBaseType* lanczosOrDavidson = 0;
 
 			bool useDavidson = (parameters_.options.find("useDavidson")!=std::string::npos);
@@ -435,6 +485,9 @@ namespace Dmrg {
 		const size_t& quantumSector_; // this needs to be a reference since DmrgSolver will change it
 		WaveFunctionTransfType& wft_;
 		double oldEnergy_;
+		RealType truncationError_;
+		RealType lanczosEps_;
+		KrylovWorkspaceType krylovWorkspace_; // reused by all sectors and steps with useBlockLanczos
 	}; // class Diagonalization
 } // namespace Dmrg 
 
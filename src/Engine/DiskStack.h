@@ -78,8 +78,15 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "Stack.h"
 #include "IoSimple.h"
 #include "ProgressIndicator.h"
+#include <fstream>
+#include "IoBinary.h"
 
 //! A disk stack, similar to std::stack but stores in disk not in memory
+//! The text format appends each element to the file, and reads element
+//! n by scanning the file for its n-th #NAME= line
+//! The binary format (binary=true) has a header, one record per element
+//! (length, checksum, IoBinary bytes) and a footer with the stack and the
+//! byte offset of each record, so that top() is a seek and a read
 namespace Dmrg {
 	template<typename DataType>
 	class DiskStack {
@@ -88,13 +95,22 @@ namespace Dmrg {
 		typedef typename PsimagLite::IoSimple::Out IoOutType;
 
 		public:
-			DiskStack(const std::string &file1,const std::string &file2,bool hasLoad,size_t rank=0) :
+			DiskStack(const std::string &file1,
+			          const std::string &file2,
+			          bool hasLoad,
+			          size_t rank=0,
+			          bool binary=false) :
 				rank_(rank),
 				fileIn_(file1),
 				fileOut_(file2),
 				total_(0),
-				progress_("DiskStack",rank)
+				progress_("DiskStack",rank),
+				binary_(binary)
 			{
+				if (binary_) {
+					openBinary(hasLoad);
+					return;
+				}
 				if (!hasLoad) {
 					ioOut_.open(fileOut_,std::ios_base::trunc,rank_);
 					ioOut_.close();
@@ -120,6 +136,10 @@ namespace Dmrg {
 			
 			~DiskStack()
 			{
+				if (binary_) {
+					closeBinary();
+					return;
+				}
 				//ioOut_.open(fileOut_,std::ios_base::trunc,rank_);
 				ioOut_.open(fileOut_,std::ios_base::app,rank_);
 //				ioOut_.print("#STACKMETARANK=",rank_);
@@ -137,6 +157,10 @@ namespace Dmrg {
 
 			void push(DataType const &d) 
 			{
+				if (binary_) {
+					pushBinary(d);
+					return;
+				}
 				//std::string tmpLabel = fileOut_ + ttos(total_);
 				ioOut_.open(fileOut_,std::ios_base::app,rank_);
 				d.save(ioOut_);
@@ -163,6 +187,7 @@ namespace Dmrg {
 
 			DataType top()
 			{
+				if (binary_) return topBinary();
 				ioIn_.open(fileIn_);
 				DataType dt(ioIn_,"",stack_.top());
 //				std::string s = "Topping with label="+fileIn_+" stack_.top="+ttos(stack_.top());
@@ -180,6 +205,114 @@ namespace Dmrg {
 
 		private:
 
+			//! The output is truncated, so the input is read, and refused
+			//! if it is the same file, before the output is opened
+			void openBinary(bool hasLoad)
+			{
+				if (hasLoad) loadBinary();
+				binOut_.open(fileOut_.c_str(),std::ios::binary | std::ios::trunc);
+				if (!binOut_ || !IoBinary::littleEndian())
+					binaryError("cannot write " + fileOut_);
+				binOut_.write(HEADER,HEADER_SIZE);
+			}
+
+			void loadBinary()
+			{
+				if (fileIn_==fileOut_)
+					binaryError("cannot read from and write to the same file " + fileIn_);
+
+				binIn_.open(fileIn_.c_str(),std::ios::binary);
+				char tag[HEADER_SIZE];
+				binIn_.read(tag,HEADER_SIZE);
+				if (!binIn_ || memcmp(tag,HEADER,HEADER_SIZE)!=0)
+					binaryError(fileIn_ + " is not a binary stack");
+
+				// the footer ends with its own offset and the trailer tag
+				size_t footer = 0;
+				binIn_.seekg(-static_cast<long>(sizeof(size_t)+HEADER_SIZE),std::ios::end);
+				binIn_.read(reinterpret_cast<char*>(&footer),sizeof(size_t));
+				binIn_.read(tag,HEADER_SIZE);
+				if (!binIn_ || memcmp(tag,TRAILER,HEADER_SIZE)!=0)
+					binaryError(fileIn_ + " has no index, was the run interrupted?");
+
+				std::string bytes = readBinary(footer);
+				IoBinaryBuffer buf(bytes.data(),bytes.size());
+				std::vector<int> stack;
+				binaryRead(buf,rank_);
+				binaryRead(buf,stack);
+				binaryRead(buf,inOffsets_);
+				for (size_t i=0;i<stack.size();i++) stack_.push(stack[i]);
+
+				std::ostringstream msg;
+				msg<<"Attempting to read from file " + fileIn_ + " succeeded";
+				progress_.printline(msg,std::cout);
+			}
+
+			void closeBinary()
+			{
+				std::vector<int> stack(stack_.size());
+				std::stack<int> tmp = stack_;
+				for (size_t i=stack.size();i>0;i--) {
+					stack[i-1] = tmp.top();
+					tmp.pop();
+				}
+				std::string bytes;
+				binaryWrite(bytes,rank_);
+				binaryWrite(bytes,stack);
+				binaryWrite(bytes,outOffsets_);
+				size_t footer = writeBinary(bytes);
+				binOut_.write(reinterpret_cast<const char*>(&footer),sizeof(size_t));
+				binOut_.write(TRAILER,HEADER_SIZE);
+				binOut_.close();
+			}
+
+			void pushBinary(const DataType& d)
+			{
+				IoBinary::Out io;
+				d.save(io);
+				outOffsets_.push_back(writeBinary(io.buffer()));
+				stack_.push(total_);
+				total_++;
+			}
+
+			DataType topBinary()
+			{
+				size_t index = stack_.top();
+				if (index>=inOffsets_.size()) binaryError("no record " + ttos(index) + " in " + fileIn_);
+				std::string bytes = readBinary(inOffsets_[index]);
+				IoBinary::In io(bytes.data(),bytes.size());
+				return DataType(io,"",0);
+			}
+
+			size_t writeBinary(const std::string& bytes)
+			{
+				size_t offset = IoBinary::writeRecord(binOut_,bytes);
+				if (!binOut_) binaryError("writing to " + fileOut_ + " failed");
+				return offset;
+			}
+
+			std::string readBinary(size_t offset)
+			{
+				std::string bytes;
+				unsigned int sum = 0;
+				if (!IoBinary::readRecord(binIn_,offset,bytes,sum))
+					binaryError("reading from " + fileIn_ + " failed");
+				if (IoBinary::checksum(bytes.data(),bytes.size())!=sum)
+					binaryError("checksum mismatch in " + fileIn_ + " at offset " + ttos(offset));
+				return bytes;
+			}
+
+			void binaryError(const std::string& what) const
+			{
+				std::string s(__FILE__);
+				s += ": DiskStack: " + what + "\n";
+				throw std::runtime_error(s.c_str());
+			}
+
+			static const char* HEADER;
+			static const char* TRAILER;
+			static const size_t HEADER_SIZE = 8;
+
 			size_t rank_;
 			std::string fileIn_,fileOut_;
 			int total_;
@@ -187,8 +320,19 @@ namespace Dmrg {
 			IoInType ioIn_;
 			IoOutType ioOut_;
 			std::stack<int> stack_;
+			bool binary_;
+			std::ofstream binOut_;
+			std::ifstream binIn_;
+			std::vector<size_t> outOffsets_;
+			std::vector<size_t> inOffsets_;
 	}; // class DiskStack
 
+	template<typename DataType>
+	const char* DiskStack<DataType>::HEADER = "DMRGSTK1";
+
+	template<typename DataType>
+	const char* DiskStack<DataType>::TRAILER = "DMRGIDX1";
+
 	template<typename DataType>
 	std::ostream& operator<<(std::ostream& os,const DiskStack<DataType>& ds)
 	{
@@ -105,20 +105,24 @@ public:
 		       const LeftRightSuperType& lrs,
 		       const VectorType& wf,
 		       const SparseMatrixType& transform,
-		       size_t direction)
+		       size_t direction,
+		       bool withOperators = false)
 		: fS_(fS),
 		  fE_(fE),
 		  lrs_(lrs),
 		  wavefunction_(wf),
 		  transform_(transform),
-		  direction_(direction)
+		  direction_(direction),
+		  withOperators_(withOperators)
 	{}
 
 
-	DmrgSerializer(typename PsimagLite::IoSimple::In& io,bool bogus = false)
+	template<typename IoInputter>
+	DmrgSerializer(IoInputter& io,bool bogus = false)
 		: fS_(io,bogus),
 		  fE_(io,bogus),
-		  lrs_(io)
+		  lrs_(io),
+		  withOperators_(false)
 	{
 		if (bogus) return;
 		std::string s = "#WAVEFUNCTION_sites=";
@@ -134,12 +138,15 @@ public:
 	}
 
 	// Save to disk everything needed to compute any observable (OBSOLETE!!)
+	// The block operators are not needed, and are saved only if
+	// withOperators was given
 	template<typename IoOutputter>
 	void save(IoOutputter& io) const
 	{
 		fS_.save(io);
 		fE_.save(io);
-		lrs_.save(io);
+		if (withOperators_) lrs_.save(io);
+		else lrs_.saveWithoutOperators(io);
 
 		// save wavefunction
 		std::string label = "#WAVEFUNCTION_sites=";
@@ -220,6 +227,7 @@ private:
 	VectorType wavefunction_;
 	SparseMatrixType transform_;
 	size_t direction_;
+	bool withOperators_;
 }; // class DmrgSerializer
 } // namespace Dmrg 
 
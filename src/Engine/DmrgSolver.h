@@ -90,6 +90,8 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "WaveFunctionTransfFactory.h"
 #include "Truncation.h"
 #include "MemoryUsage.h"
+#include "CrsMatrixArena.h"
+#include "IoBinaryFile.h"
 
 namespace Dmrg {
 
@@ -105,6 +107,7 @@ namespace Dmrg {
 
 	public:
 		typedef typename  OperatorsType::SparseMatrixType SparseMatrixType;
+		typedef CrsMatrixArena<SparseMatrixType> CrsMatrixArenaType;
 		typedef typename ModelType::MyBasis MyBasis;
 		typedef typename MyBasis::RealType RealType;
 		typedef typename MyBasis::BlockType BlockType;
@@ -167,6 +170,8 @@ namespace Dmrg {
 			std::string s =hostInfo.getTimeDate();
 			io_.print(s);
 			if (parameters_.options.find("verbose")!=std::string::npos) verbose_=true;
+			if (parameters_.options.find("binaryData")!=std::string::npos)
+				ioBinary_.open(IoBinaryFile::name(parameters_.filename),concurrency.rank());
 		}
 
 		~DmrgSolver()
@@ -301,6 +306,7 @@ namespace Dmrg {
 				diagonalization_(psi,INFINITE,X[step],Y[step]);
 
 				truncate_.changeBasis(pS,pE,psi,parameters_.keptStatesInfinite);
+				diagonalization_.setTruncationError(truncate_.error());
 
 				checkpoint_.push(pS,pE);
 
@@ -396,10 +402,12 @@ namespace Dmrg {
 				RealType time = target.time();
 				if (direction==EXPAND_SYSTEM) {
 					lrs_.growLeftBlock(model_,pS,sitesIndices_[stepCurrent_],time);
-					lrs_.right(checkpoint_.shrink(ProgramGlobals::ENVIRON,target));
+					// the top of the stack is used in place, not copied; nothing is
+					// pushed over it before this block is grown again
+					lrs_.borrowRight(checkpoint_.shrink(ProgramGlobals::ENVIRON,target));
 				} else {
 					lrs_.growRightBlock(model_,pE,sitesIndices_[stepCurrent_],time);
-					lrs_.left(checkpoint_.shrink(ProgramGlobals::SYSTEM,target));
+					lrs_.borrowLeft(checkpoint_.shrink(ProgramGlobals::SYSTEM,target));
 				}
 
 				lrs_.printSizes("finite",std::cout);
@@ -420,6 +428,9 @@ namespace Dmrg {
 
 				changeTruncateAndSerialize(pS,pE,target,keptStates,direction,saveOption);
 
+				// temporaries of this step are back in the arena
+				CrsMatrixArenaType::reset();
+
 				if (finalStep(stepLength,stepFinal)) break;
 				if (stepCurrent_<0) throw std::runtime_error("DmrgSolver::finiteStep() currentStep_ is negative\n");
 
@@ -456,6 +467,7 @@ namespace Dmrg {
 			std::ostringstream msg2;
 			msg2<<"#Error="<<truncate_.error();
 			io_.printline(msg2);
+			diagonalization_.setTruncationError(truncate_.error());
 
 			if (direction==EXPAND_SYSTEM) {
 				checkpoint_.push(pS,ProgramGlobals::SYSTEM);
@@ -472,7 +484,16 @@ namespace Dmrg {
 			       const SparseMatrixType& transform,
 		               size_t direction)
 		{
-			DmrgSerializerType ds(fsS,fsE,lrs_,target.gs(),transform,direction);
+			bool withOperators = (parameters_.options.find("saveOperators")!=std::string::npos);
+			DmrgSerializerType ds(fsS,fsE,lrs_,target.gs(),transform,direction,withOperators);
+
+			if (ioBinary_.isOpen()) {
+				ds.save(ioBinary_);
+				target.save(sitesIndices_[stepCurrent_],ioBinary_);
+				ioBinary_.endStep();
+				if (parameters_.options.find("exportTextData")==std::string::npos)
+					return;
+			}
 
 			ds.save(io_);
 
@@ -581,6 +602,7 @@ namespace Dmrg {
 		LeftRightSuperType lrs_;
 		typename IoType::Out io_;
 		typename IoType::In ioIn_;
+		IoBinaryFile::Out ioBinary_;
 		PsimagLite::ProgressIndicator progress_;
 		size_t quantumSector_;
 		int stepCurrent_;
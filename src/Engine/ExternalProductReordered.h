@@ -0,0 +1,209 @@
+/*
+Copyright (c) 2012, UT-Battelle, LLC
+All rights reserved
+
+[DMRG++, Version 2.0.0]
+[by G.A., Oak Ridge National Laboratory]
+
+UT Battelle Open Source Software License 11242008
+
+OPEN SOURCE LICENSE
+
+Subject to the conditions of this License, each
+contributor to this software hereby grants, free of
+charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), a
+perpetual, worldwide, non-exclusive, no-charge,
+royalty-free, irrevocable copyright license to use, copy,
+modify, merge, publish, distribute, and/or sublicense
+copies of the Software.
+
+1. Redistributions of Software must retain the above
+copyright and license notices, this list of conditions,
+and the following disclaimer.  Changes or modifications
+to, or derivative works of, the Software should be noted
+with comments and the contributor and organization's
+name.
+
+2. Neither the names of UT-Battelle, LLC or the
+Department of Energy nor the names of the Software
+contributors may be used to endorse or promote products
+derived from this software without specific prior written
+permission of UT-Battelle.
+
+3. The software and the end-user documentation included
+with the redistribution, with or without modification,
+must include the following acknowledgment:
+
+"This product includes software produced by UT-Battelle,
+LLC under Contract No. DE-AC05-00OR22725  with the
+Department of Energy."
+
+*********************************************************
+DISCLAIMER
+
+THE SOFTWARE IS SUPPLIED BY THE COPYRIGHT HOLDERS AND
+CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER, CONTRIBUTORS, UNITED STATES GOVERNMENT,
+OR THE UNITED STATES DEPARTMENT OF ENERGY BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+DAMAGE.
+
+NEITHER THE UNITED STATES GOVERNMENT, NOR THE UNITED
+STATES DEPARTMENT OF ENERGY, NOR THE COPYRIGHT OWNER, NOR
+ANY OF THEIR EMPLOYEES, REPRESENTS THAT THE USE OF ANY
+INFORMATION, DATA, APPARATUS, PRODUCT, OR PROCESS
+DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
+
+*********************************************************
+
+
+*/
+// END LICENSE BLOCK
+/** \ingroup DMRG */
+/*@{*/
+/*! \file ExternalProductReordered.h
+ *
+ *  External product of a block operator with the identity on the other
+ *  basis, written directly in the order of the product basis sorted by
+ *  quantum numbers. This replaces PsimagLite::externalProduct followed
+ *  by permute and permuteInverse, and needs no temporary matrices
+ *
+ *  The product basis has the state i2 of the left basis as the fast
+ *  index, i = i2 + i3*n2, and new state i is old state permutation[i]
+ *
+ */
+
+#ifndef EXTERNAL_PRODUCT_REORDERED_H
+#define EXTERNAL_PRODUCT_REORDERED_H
+
+#include <vector>
+#include <cassert>
+
+namespace Dmrg {
+
+//! Inverse of a permutation, inverse[permutation[i]] = i
+inline void invertPermutation(std::vector<size_t>& inverse,const std::vector<size_t>& permutation)
+{
+	inverse.resize(permutation.size());
+	for (size_t i=0;i<permutation.size();i++) inverse[permutation[i]] = i;
+}
+
+//! If option is true c = a x 1, with a on the left basis, else c = 1 x a,
+//! with a on the right basis and signs (indexed by the left basis) for
+//! its fermionic character; nout is the size of the identity
+template<typename SparseMatrixType>
+void externalProductReordered(SparseMatrixType& c,
+			      const SparseMatrixType& a,
+			      size_t nout,
+			      const std::vector<double>& signs,
+			      bool option,
+			      const std::vector<size_t>& permutation,
+			      const std::vector<size_t>& permutationInverse)
+{
+	typedef typename SparseMatrixType::value_type ComplexOrRealType;
+
+	size_t na = a.row();
+	size_t n = na*nout;
+	assert(permutation.size()==n);
+	assert(option || signs.size()==nout);
+
+	c.resize(n,n);
+	size_t counter = 0;
+	for (size_t i=0;i<n;i++) {
+		c.setRow(i,counter);
+		size_t old = permutation[i];
+		// ia is the state of a, ix the state of the identity
+		size_t ia = (option) ? old % na : old / nout;
+		size_t ix = (option) ? old / na : old % nout;
+		ComplexOrRealType sign = (option) ? 1.0 : signs[ix];
+		for (int k=a.getRowPtr(ia);k<a.getRowPtr(ia+1);k++) {
+			size_t ja = a.getCol(k);
+			size_t oldCol = (option) ? ja + ix*na : ix + ja*nout;
+			c.pushCol(permutationInverse[oldCol]);
+			c.pushValue(a.getValue(k)*sign);
+			counter++;
+		}
+	}
+	c.setRow(n,counter);
+	c.checkValidity();
+}
+
+//! Operator k of dest becomes the reordered external product of *sources[k],
+//! the first nLeft of them on the left basis; distributed over threads
+template<typename OperatorType>
+class ParallelExternalProduct {
+
+public:
+
+	ParallelExternalProduct(std::vector<OperatorType>& dest,
+				const std::vector<const OperatorType*>& sources,
+				size_t nLeft,
+				size_t sizeLeft,
+				size_t sizeRight,
+				const std::vector<size_t>& electronsLeft,
+				const std::vector<size_t>& permutation,
+				const std::vector<size_t>& permutationInverse)
+	: dest_(dest),
+	  sources_(sources),
+	  nLeft_(nLeft),
+	  sizeLeft_(sizeLeft),
+	  sizeRight_(sizeRight),
+	  signsOdd_(electronsLeft.size()),
+	  signsEven_(electronsLeft.size(),1.0),
+	  permutation_(permutation),
+	  permutationInverse_(permutationInverse)
+	{
+		for (size_t i=0;i<signsOdd_.size();i++)
+			signsOdd_[i] = (electronsLeft[i]%2==0) ? 1.0 : -1.0;
+	}
+
+	void thread_function_(size_t threadNum,size_t blockSize,size_t total,pthread_mutex_t* myMutex)
+	{
+		for (size_t p=0;p<blockSize;p++) {
+			size_t ix = threadNum * blockSize + p;
+			if (ix>=total) break;
+			const OperatorType& src = *sources_[ix];
+			OperatorType& op = dest_[ix];
+			if (src.data.row()==0) {
+				// dropped, see OperatorsBase::changeBasis
+				op = src;
+				continue;
+			}
+			bool option = (ix<nLeft_);
+			size_t nout = (option) ? sizeRight_ : sizeLeft_;
+			const std::vector<double>& signs = (src.fermionSign<0) ? signsOdd_ : signsEven_;
+			externalProductReordered(op.data,src.data,nout,signs,option,
+						 permutation_,permutationInverse_);
+			op.fermionSign = src.fermionSign;
+			op.jm = src.jm;
+			op.angularFactor = src.angularFactor;
+		}
+	}
+
+private:
+
+	std::vector<OperatorType>& dest_;
+	const std::vector<const OperatorType*>& sources_;
+	size_t nLeft_;
+	size_t sizeLeft_;
+	size_t sizeRight_;
+	std::vector<double> signsOdd_;
+	std::vector<double> signsEven_;
+	const std::vector<size_t>& permutation_;
+	const std::vector<size_t>& permutationInverse_;
+}; // class ParallelExternalProduct
+} // namespace Dmrg
+
+/*@}*/
+#endif // EXTERNAL_PRODUCT_REORDERED_H
@@ -90,17 +90,21 @@ namespace Dmrg {
 			typedef typename ModelHelperType::RealType RealType;
 			typedef typename ModelHelperType::SparseMatrixType SparseMatrixType;
 			typedef typename SparseMatrixType::value_type SparseElementType;
-			typedef LinkProductStruct<SparseElementType> LinkProductStructType;
 			typedef typename ModelHelperType::LinkType LinkType;
+			typedef typename ModelHelperType::LinkProductStructType LinkProductStructType;
 			typedef std::pair<size_t,size_t> PairType;
 			typedef typename GeometryType::AdditionalDataType AdditionalDataType;
 
 			HamiltonianConnection(const GeometryType& geometry,const ModelHelperType& modelHelper,const LinkProductStructType* lps = 0,
 			std::vector<SparseElementType>* x = 0,
-			const std::vector<SparseElementType>* y = 0)
+			const std::vector<SparseElementType>* y = 0,
+			bool withBlockHamiltonians = false,
+			size_t nvectors = 1)
 			: geometry_(geometry),
 			  modelHelper_(modelHelper),
 			  lps_(*lps),x_(*x),y_(*y),
+			  withBlockHamiltonians_(withBlockHamiltonians),
+			  nvectors_(nvectors),
 			  systemBlock_(modelHelper.leftRightSuper().left().block()),
 			  envBlock_(modelHelper.leftRightSuper().right().block()),
 			  smax_(*std::max_element(systemBlock_.begin(),systemBlock_.end())),
@@ -138,14 +142,10 @@ namespace Dmrg {
 						// if .. else here is inefficient FIXME
 						//std::cerr<<"Adding "<<i<<" "<<j<<" term"<<term<<" dofs="<<dofs<<" value="<<tmp<<"\n";
 						if (lps!=0) {
-							lps->isaved[total]=i;
-							lps->jsaved[total]=j;
-							//lps->dof1saved.push_back(dof1);
-							//lps->dof2saved.push_back(dof2);
-							lps->typesaved[total]=type;
-							lps->tmpsaved[total]=tmp;
-							lps->termsaved[total]=term;
-							lps->dofssaved[total]=dofs;
+							SparseMatrixType const* A = 0;
+							SparseMatrixType const* B = 0;
+							LinkType link2 = getKron(&A,&B,i,j,type,tmp,term,dofs);
+							lps->push(link2,A,B);
 							total++;
 						} else {
 							calcBond(mBlock,i,j,type,tmp,term,dofs);
@@ -156,35 +156,31 @@ namespace Dmrg {
 				return flag;
 			}
 
+			//! Thread threadNum owns rows [threadNum*blockSize,(threadNum+1)*blockSize)
+			//! of x and applies every link to them, so x needs neither a lock nor a reduction
+			//! If withBlockHamiltonians was set, the system and environment
+			//! Hamiltonians are applied to these rows as well
+			//! If nvectors>1 then x and y hold that many vectors interleaved, and
+			//! total is the number of rows, not x.size()
 			void thread_function_(size_t threadNum,size_t blockSize,size_t total,pthread_mutex_t* myMutex)
 			{
-				std::vector<SparseElementType> xtemp(x_.size(),0);
-				size_t i =0, j = 0, type = 0,term = 0, dofs =0;
-				SparseElementType tmp = 0.0;
-				for (size_t p=0;p<blockSize;p++) {
-					size_t ix = threadNum * blockSize + p;
-					if (ix>=total) break;
-					prepare(ix,i,j,type,tmp,term,dofs);
-
-					linkProduct(xtemp,y_,i,j,type,tmp,term,dofs);
-					
+				size_t rowStart = threadNum * blockSize;
+				if (rowStart>=total) return;
+				size_t rowEnd = rowStart + blockSize;
+				if (rowEnd>total) rowEnd = total;
+
+				if (nvectors_>1) {
+					threadVectors(rowStart,rowEnd);
+					return;
 				}
-				if (myMutex) pthread_mutex_lock( myMutex);
-				for (size_t i=0;i<x_.size();i++) x_[i]+=xtemp[i];
-				if (myMutex) pthread_mutex_unlock( myMutex );
-			}
 
-			void prepare(size_t ix,size_t& i,size_t& j,size_t& type,SparseElementType& tmp,size_t& term,size_t& dofs) const
-			{
-				i=lps_.isaved[ix];
-				j=lps_.jsaved[ix];
-				type=lps_.typesaved[ix];
-				term = lps_.termsaved[ix];
-				dofs = lps_.dofssaved[ix];
-				tmp=lps_.tmpsaved[ix];
-				size_t ind = modelHelper_.leftRightSuper().super().block()[i];
-				size_t jnd = modelHelper_.leftRightSuper().super().block()[j];
-				geometry_.fillAdditionalData(additionalData_,term,ind,jnd);
+				if (withBlockHamiltonians_) {
+					modelHelper_.hamiltonianLeftProduct(x_,y_,rowStart,rowEnd);
+					modelHelper_.hamiltonianRightProduct(x_,y_,rowStart,rowEnd);
+				}
+
+				for (size_t ix=0;ix<lps_.size();ix++)
+					modelHelper_.fastOpProdInter(x_,y_,*lps_.A[ix],*lps_.B[ix],lps_.links[ix],rowStart,rowEnd);
 			}
 
 			LinkType getKron(const SparseMatrixType** A,
@@ -228,6 +224,17 @@ namespace Dmrg {
 
 		private:
 
+			void threadVectors(size_t rowStart,size_t rowEnd)
+			{
+				if (withBlockHamiltonians_) {
+					modelHelper_.hamiltonianLeftProductVectors(x_,y_,rowStart,rowEnd,nvectors_);
+					modelHelper_.hamiltonianRightProductVectors(x_,y_,rowStart,rowEnd,nvectors_);
+				}
+
+				for (size_t ix=0;ix<lps_.size();ix++)
+					modelHelper_.fastOpProdInterVectors(x_,y_,*lps_.A[ix],*lps_.B[ix],lps_.links[ix],rowStart,rowEnd,nvectors_);
+			}
+
 			//! Adds a connector between system and environment
 			size_t calcBond(SparseMatrixType &matrixBlock,
 					size_t i,
@@ -245,27 +252,13 @@ namespace Dmrg {
 				return matrixBlock.nonZero();
 			}
 
-			//! Computes x+=H_{ij}y where H_{ij} is a Hamiltonian that connects system and environment 
-			void linkProduct(std::vector<SparseElementType> &x,
-					 std::vector<SparseElementType> const &y,
-					 size_t i,
-					 size_t j,
-					 size_t type,
-					 const SparseElementType &valuec,
-					 size_t term,
-					 size_t dofs) const
-			{
-				SparseMatrixType const* A = 0;
-				SparseMatrixType const* B = 0;
-				LinkType link2 = getKron(&A,&B,i,j,type,valuec,term,dofs);
-				modelHelper_.fastOpProdInter(x,y,*A,*B,link2);
-			}
-
 			const GeometryType& geometry_;
 			const ModelHelperType& modelHelper_;
 			const LinkProductStructType& lps_;
 			std::vector<SparseElementType>& x_;
 			const std::vector<SparseElementType>& y_;
+			bool withBlockHamiltonians_;
+			size_t nvectors_;
 			const typename GeometryType::BlockType& systemBlock_;
 			const typename GeometryType::BlockType& envBlock_;
 			size_t smax_,emin_;
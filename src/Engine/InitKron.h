@@ -75,6 +75,10 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 
 /*! \file InitKron.h
  *
+ *  Prepares the Kronecker form of one symmetry sector of the superblock
+ *  Hamiltonian: the sector is split into patches (left QN group, right QN group),
+ *  each patch is a dense block of the vector, and the system Hamiltonian,
+ *  environment Hamiltonian and every connection are stored as dense QN blocks
  *
  */
 
@@ -83,16 +87,20 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 
 #include "GenIjPatch.h"
 #include "ArrayOfMatStruct.h"
+#include "PackIndices.h" // in PsimagLite
 
 namespace Dmrg {
 
 template<typename ModelType,typename ModelHelperType_>
 class InitKron {
 
+	typedef PsimagLite::PackIndices PackIndicesType;
+
 public:
 
 	typedef ModelHelperType_ ModelHelperType;
 	typedef typename ModelHelperType::RealType RealType;
+	typedef typename ModelHelperType::ConcurrencyType ConcurrencyType;
 	typedef typename ModelHelperType::SparseMatrixType SparseMatrixType;
 	typedef typename SparseMatrixType::value_type ComplexOrRealType;
 	typedef typename ModelHelperType::LeftRightSuperType LeftRightSuperType;
@@ -116,29 +124,25 @@ public:
 	  gengroupLeft_(modelHelper_.leftRightSuper().left()),
 	  gengroupRight_(modelHelper_.leftRightSuper().right()),
 	  ijpatches_(modelHelper_.leftRightSuper(),modelHelper_.quantumNumber()),
+	  patchIndex_((gengroupLeft_.size()-1)*(gengroupRight_.size()-1),-1),
+	  patchOffset_(ijpatches_.size()+1,0),
 	  aL_(modelHelper_.leftRightSuper().left().hamiltonian(),gengroupLeft_),
-	  aRt_(0)
+	  aR_(modelHelper_.leftRightSuper().right().hamiltonian(),gengroupRight_)
 	{
-		SparseMatrixType arTranspose;
-		transposeConjugate(arTranspose,modelHelper_.leftRightSuper().right().hamiltonian());
-
-//		std::cerr<<"gengroupLeft_.size="<<gengroupLeft_.size()<<"\n";
-//		std::cerr<<"gengroupRight_.size="<<gengroupRight_.size()<<"\n";
-
-		aRt_ = new ArrayOfMatStructType(arTranspose,gengroupRight_);
+		if (ModelHelperType::isSu2()) {
+			std::string s(__FILE__);
+			s += " InternalProductKron does not support SU(2) symmetry\n";
+			throw std::runtime_error(s.c_str());
+		}
 
+		setPatches();
 		convertXcYcArrays();
-//		printFullMatrix(modelHelper_.leftRightSuper().left().hamiltonian(),"LEFT HAM");
-//		printFullMatrix(modelHelper_.leftRightSuper().right().hamiltonian(),"RIGHT HAM");
 	}
 
 	~InitKron()
 	{
-		if (aRt_) delete aRt_;
-
 		for (size_t ic=0;ic<xc_.size();ic++) delete xc_[ic];
 		for (size_t ic=0;ic<yc_.size();ic++) delete yc_[ic];
-
 	}
 
 	size_t numberOfThreads() const
@@ -165,6 +169,27 @@ public:
 
 	size_t patch() const {return ijpatches_.size(); }
 
+	//! Patch number of left group i and right group j, or -1 if not in this sector
+	int patch(size_t i,size_t j) const
+	{
+		return patchIndex_[i+j*(gengroupLeft_.size()-1)];
+	}
+
+	//! Patch p occupies [offset(p),offset(p+1)) of the patch-ordered vector,
+	//! stored column-major as a matrix of istartLeft size x istartRight size
+	size_t patchOffset(size_t p) const
+	{
+		assert(p<patchOffset_.size());
+		return patchOffset_[p];
+	}
+
+	//! Index in the patch-ordered vector of row r of this sector
+	size_t patchOrdered(size_t r) const
+	{
+		assert(r<patchOrdered_.size());
+		return patchOrdered_[r];
+	}
+
 	const LeftRightSuperType& lrs() const
 	{
 		return modelHelper_.leftRightSuper();
@@ -180,9 +205,9 @@ public:
 
 	size_t connections() const { return xc_.size(); }
 
-	const ArrayOfMatStructType& aRt () const
+	const ArrayOfMatStructType& aR() const
 	{
-		return *aRt_;
+		return aR_;
 	}
 
 	const ArrayOfMatStructType& aL() const
@@ -208,44 +233,82 @@ public:
 
 private:
 
-	void convertXcYcArrays()
+	void setPatches()
 	{
-		LinkProductStructType* lps = 0;
-		size_t total = model_.getLinkProductStruct(&lps,modelHelper_);
+		size_t nleftGroups = gengroupLeft_.size()-1;
+		size_t npatches = ijpatches_.size();
+		for (size_t p=0;p<npatches;p++) {
+			size_t i = ijpatches_(GenIjPatchType::LEFT,p);
+			size_t j = ijpatches_(GenIjPatchType::RIGHT,p);
+			patchIndex_[i+j*nleftGroups] = p;
+			size_t nl = gengroupLeft_(i+1) - gengroupLeft_(i);
+			size_t nr = gengroupRight_(j+1) - gengroupRight_(j);
+			patchOffset_[p+1] = patchOffset_[p] + nl*nr;
+		}
+
+		size_t nq = size();
+		if (patchOffset_[npatches]!=nq) {
+			std::string s(__FILE__);
+			s += " patches do not cover the symmetry sector\n";
+			throw std::runtime_error(s.c_str());
+		}
+
+		const LeftRightSuperType& lrs = modelHelper_.leftRightSuper();
+		std::vector<size_t> groupLeft(lrs.left().size());
+		for (size_t i=0;i<nleftGroups;i++)
+			for (size_t a=gengroupLeft_(i);a<gengroupLeft_(i+1);a++) groupLeft[a] = i;
+		std::vector<size_t> groupRight(lrs.right().size());
+		for (size_t j=0;j<gengroupRight_.size()-1;j++)
+			for (size_t b=gengroupRight_(j);b<gengroupRight_(j+1);b++) groupRight[b] = j;
+
+		size_t offset = this->offset();
+		PackIndicesType pack(lrs.left().size());
+		patchOrdered_.resize(nq);
+		for (size_t r=0;r<nq;r++) {
+			size_t alpha = 0, beta = 0;
+			pack.unpack(alpha,beta,lrs.super().permutation(r+offset));
+			size_t i = groupLeft[alpha];
+			size_t j = groupRight[beta];
+			int p = patch(i,j);
+			assert(p>=0);
+			size_t nl = gengroupLeft_(i+1) - gengroupLeft_(i);
+			patchOrdered_[r] = patchOffset_[p] + (alpha-gengroupLeft_(i)) + (beta-gengroupRight_(j))*nl;
+		}
+	}
 
-		for (size_t ix=0;ix<total;ix++) {
-			SparseMatrixType const* A = 0;
-			SparseMatrixType const* B = 0;
+	void convertXcYcArrays()
+	{
+		const LinkProductStructType& lps = model_.linkProductStruct(modelHelper_);
 
-			LinkType link2 = model_.getConnection(&A,&B,ix,*lps,modelHelper_);
-//			assert(link2.fermionOrBoson==ProgramGlobals::BOSON);
+		for (size_t ix=0;ix<lps.size();ix++) {
+			const LinkType& link2 = lps.links[ix];
 			if (link2.type==ProgramGlobals::ENVIRON_SYSTEM)  {
 				LinkType link3 = link2;
-				//link3.value *= fermionSign;
+				if (link3.fermionOrBoson==ProgramGlobals::FERMION) link3.value *= -1.0;
 				link3.type = ProgramGlobals::SYSTEM_ENVIRON;
-				addOneConnection(*B,*A,link3);
+				addOneConnection(*lps.B[ix],*lps.A[ix],link3);
 				continue;
 			}
-			addOneConnection(*A,*B,link2);
+			addOneConnection(*lps.A[ix],*lps.B[ix],link2);
 		}
-//		std::cerr<<"Toooooootttttttttaaaaaaaaaaaaaallllllll="<<total<<"\n";
-
-		if (lps) delete lps;
 	}
 
+	//! The fermion sign of the system rows is folded into the blocks of A
 	void addOneConnection(const SparseMatrixType& A,const SparseMatrixType& B,const LinkType& link2)
 	{
 		values_.push_back(link2.value);
-//			assert(std::norm(tmp-0.5)<1e-6);
-		ArrayOfMatStructType* x1 = new ArrayOfMatStructType(A,gengroupLeft_);
-		xc_.push_back(x1);
-
-		SparseMatrixType tmpMatrix;
-		transposeConjugate(tmpMatrix,B);
-		ArrayOfMatStructType* y1 = new ArrayOfMatStructType(tmpMatrix,gengroupRight_);
-		yc_.push_back(y1);
-	}
 
+		std::vector<ComplexOrRealType> signs;
+		if (link2.fermionOrBoson==ProgramGlobals::FERMION) {
+			const LeftRightSuperType& lrs = modelHelper_.leftRightSuper();
+			signs.resize(lrs.left().size());
+			for (size_t alpha=0;alpha<signs.size();alpha++)
+				signs[alpha] = lrs.left().fermionicSign(alpha,-1);
+		}
+
+		xc_.push_back(new ArrayOfMatStructType(A,gengroupLeft_,signs));
+		yc_.push_back(new ArrayOfMatStructType(B,gengroupRight_));
+	}
 
 	InitKron(const InitKron& other);
 
@@ -253,17 +316,19 @@ private:
 
 	const ModelType& model_;
 	const ModelHelperType& modelHelper_;
-//	QvalStructType qvalStruct_;
 	GenGroupType gengroupLeft_,gengroupRight_;
 	GenIjPatchType  ijpatches_;
+	std::vector<int> patchIndex_;
+	std::vector<size_t> patchOffset_;
+	std::vector<size_t> patchOrdered_;
 	ArrayOfMatStructType aL_;
-	ArrayOfMatStructType* aRt_; // <-- we own it also, it's newed and deleted here
-	std::vector<ArrayOfMatStructType*> xc_;
+	ArrayOfMatStructType aR_;
+	std::vector<ArrayOfMatStructType*> xc_; // <-- we own these, they're newed and deleted here
 	std::vector<ArrayOfMatStructType*> yc_;
 	std::vector<ComplexOrRealType> values_;
 
 }; //class InitKron
-} // namespace PsimagLite
+} // namespace Dmrg
 
 /*@}*/
 
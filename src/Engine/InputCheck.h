@@ -130,6 +130,8 @@ namespace Dmrg {
 			registerOpts.push_back("debugmatrix");
 			registerOpts.push_back("test");
 			registerOpts.push_back("useDavidson");
+			registerOpts.push_back("useBlockLanczos");
+			registerOpts.push_back("adaptiveLanczosEps");
 			registerOpts.push_back("verbose");
 			registerOpts.push_back("nofiniteloops");
 			registerOpts.push_back("nowft");
@@ -138,6 +140,14 @@ namespace Dmrg {
 			registerOpts.push_back("ChebyshevSolver");
 			registerOpts.push_back("InternalProductStored");
 			registerOpts.push_back("InternalProductKron");
+			registerOpts.push_back("useBlockedKernel");
+			registerOpts.push_back("partialDensityMatrixDiag");
+			registerOpts.push_back("lazyOperators");
+			registerOpts.push_back("onlyNeededOperators");
+			registerOpts.push_back("binaryStacks");
+			registerOpts.push_back("binaryData");
+			registerOpts.push_back("exportTextData");
+			registerOpts.push_back("saveOperators");
 			registerOpts.push_back("useSu2Symmetry");
 			registerOpts.push_back("TimeStepTargetting");
 			registerOpts.push_back("DynamicTargetting");
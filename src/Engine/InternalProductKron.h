@@ -112,6 +112,22 @@ namespace Dmrg {
 			 kronMatrix_.matrixVectorProduct(x,y);
 		}
 
+		//! x += H y for nvectors vectors stored interleaved, one vector at a time
+		template<typename SomeVectorType>
+		void matrixMatrixProduct(SomeVectorType &x,SomeVectorType const &y,size_t nvectors) const
+		{
+			size_t n = rank();
+			SomeVectorType xv(n),yv(n);
+			for (size_t v=0;v<nvectors;v++) {
+				for (size_t i=0;i<n;i++) {
+					xv[i] = 0.0;
+					yv[i] = y[i*nvectors+v];
+				}
+				kronMatrix_.matrixVectorProduct(xv,yv);
+				for (size_t i=0;i<n;i++) x[i*nvectors+v] += xv[i];
+			}
+		}
+
 		size_t reflectionSector() const { return 0; }
 
 		void reflectionSector(size_t p) {  }
@@ -110,6 +110,13 @@ namespace Dmrg {
 			 model_->matrixVectorProduct(x,y,*modelHelper_);
 		}
 
+		//! x += H y for nvectors vectors stored interleaved, entry i of vector v being x[i*nvectors+v]
+		template<typename SomeVectorType>
+		void matrixMatrixProduct(SomeVectorType &x,SomeVectorType const &y,size_t nvectors) const
+		{
+			 model_->matrixMatrixProduct(x,y,nvectors,*modelHelper_);
+		}
+
 		size_t reflectionSector() const { return 0; }
 
 		void reflectionSector(size_t p) {  }
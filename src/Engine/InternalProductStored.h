@@ -130,6 +130,20 @@ namespace Dmrg {
 			 matrixStored_[pointer_].matrixVectorProduct(x,y);
 		}
 
+		//! x += H y for nvectors vectors stored interleaved, entry i of vector v being x[i*nvectors+v]
+		template<typename SomeVectorType>
+		void matrixMatrixProduct(SomeVectorType &x, SomeVectorType const &y,size_t nvectors) const
+		{
+			const SparseMatrixType& m = matrixStored_[pointer_];
+			for (size_t i=0;i<m.row();i++) {
+				for (int k=m.getRowPtr(i);k<m.getRowPtr(i+1);k++) {
+					size_t j = m.getCol(k);
+					for (size_t v=0;v<nvectors;v++)
+						x[i*nvectors+v] += m.getValue(k)*y[j*nvectors+v];
+				}
+			}
+		}
+
 		HamiltonianElementType operator()(size_t i,size_t j) const
 		{
 			return matrixStored_[pointer_](i,j);
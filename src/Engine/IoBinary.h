@@ -0,0 +1,590 @@
+/*
+Copyright (c) 2012, UT-Battelle, LLC
+All rights reserved
+
+[DMRG++, Version 2.0.0]
+[by G.A., Oak Ridge National Laboratory]
+
+UT Battelle Open Source Software License 11242008
+
+OPEN SOURCE LICENSE
+
+Subject to the conditions of this License, each
+contributor to this software hereby grants, free of
+charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), a
+perpetual, worldwide, non-exclusive, no-charge,
+royalty-free, irrevocable copyright license to use, copy,
+modify, merge, publish, distribute, and/or sublicense
+copies of the Software.
+
+1. Redistributions of Software must retain the above
+copyright and license notices, this list of conditions,
+and the following disclaimer.  Changes or modifications
+to, or derivative works of, the Software should be noted
+with comments and the contributor and organization's
+name.
+
+2. Neither the names of UT-Battelle, LLC or the
+Department of Energy nor the names of the Software
+contributors may be used to endorse or promote products
+derived from this software without specific prior written
+permission of UT-Battelle.
+
+3. The software and the end-user documentation included
+with the redistribution, with or without modification,
+must include the following acknowledgment:
+
+"This product includes software produced by UT-Battelle,
+LLC under Contract No. DE-AC05-00OR22725  with the
+Department of Energy."
+
+*********************************************************
+DISCLAIMER
+
+THE SOFTWARE IS SUPPLIED BY THE COPYRIGHT HOLDERS AND
+CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER, CONTRIBUTORS, UNITED STATES GOVERNMENT,
+OR THE UNITED STATES DEPARTMENT OF ENERGY BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+DAMAGE.
+
+NEITHER THE UNITED STATES GOVERNMENT, NOR THE UNITED
+STATES DEPARTMENT OF ENERGY, NOR THE COPYRIGHT OWNER, NOR
+ANY OF THEIR EMPLOYEES, REPRESENTS THAT THE USE OF ANY
+INFORMATION, DATA, APPARATUS, PRODUCT, OR PROCESS
+DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
+
+*********************************************************
+
+
+*/
+// END LICENSE BLOCK
+/** \ingroup DMRG */
+/*@{*/
+/*! \file IoBinary.h
+ *
+ *  An in-memory binary counterpart of PsimagLite::IoSimple, with the
+ *  subset of its interface used to save and load bases and operators
+ *  (printline, printVector, printMatrix and readline, read, readMatrix,
+ *  advance), so that the existing save and load functions work with it.
+ *
+ *  The buffer is a sequence of records, each a kind, a label and a
+ *  payload with its length. Lines are stored as text; vectors and
+ *  sparse matrices are stored as raw arrays in the byte order of the
+ *  host, which must be little endian. Reads scan forward from the
+ *  current record for the label, as IoSimple does
+ *
+ */
+
+#ifndef IO_BINARY_H
+#define IO_BINARY_H
+
+#include <string>
+#include <vector>
+#include <complex>
+#include <sstream>
+#include <stdexcept>
+#include <cstring>
+#include "CrsMatrix.h" // in PsimagLite
+#include "Matrix.h" // in PsimagLite
+
+namespace Dmrg {
+
+class IoBinaryBuffer;
+
+// raw values, for plain old data only
+template<typename T>
+void binaryWrite(std::string& buf,const T& x);
+
+template<typename T>
+void binaryRead(IoBinaryBuffer& buf,T& x);
+
+inline void binaryWrite(std::string& buf,const std::string& x);
+
+inline void binaryRead(IoBinaryBuffer& buf,std::string& x);
+
+template<typename T1,typename T2>
+void binaryWrite(std::string& buf,const std::pair<T1,T2>& x);
+
+template<typename T1,typename T2>
+void binaryRead(IoBinaryBuffer& buf,std::pair<T1,T2>& x);
+
+template<typename T>
+void binaryWrite(std::string& buf,const std::vector<T>& x);
+
+template<typename T>
+void binaryRead(IoBinaryBuffer& buf,std::vector<T>& x);
+
+inline void binaryWrite(std::string& buf,const std::vector<size_t>& x);
+
+inline void binaryRead(IoBinaryBuffer& buf,std::vector<size_t>& x);
+
+inline void binaryWrite(std::string& buf,const std::vector<int>& x);
+
+inline void binaryRead(IoBinaryBuffer& buf,std::vector<int>& x);
+
+inline void binaryWrite(std::string& buf,const std::vector<double>& x);
+
+inline void binaryRead(IoBinaryBuffer& buf,std::vector<double>& x);
+
+inline void binaryWrite(std::string& buf,const std::vector<std::complex<double> >& x);
+
+inline void binaryRead(IoBinaryBuffer& buf,std::vector<std::complex<double> >& x);
+
+template<typename T>
+void binaryWrite(std::string& buf,const PsimagLite::CrsMatrix<T>& x);
+
+template<typename T>
+void binaryRead(IoBinaryBuffer& buf,PsimagLite::CrsMatrix<T>& x);
+
+template<typename T>
+void binaryWrite(std::string& buf,const PsimagLite::Matrix<T>& x);
+
+template<typename T>
+void binaryRead(IoBinaryBuffer& buf,PsimagLite::Matrix<T>& x);
+
+//! Bytes being read, with a cursor
+class IoBinaryBuffer {
+
+public:
+
+	IoBinaryBuffer(const char* data,size_t size)
+	: data_(data),size_(size),pos_(0)
+	{}
+
+	void get(void* dest,size_t n)
+	{
+		if (pos_+n>size_) {
+			std::string s(__FILE__);
+			s += ": read past the end of the binary record\n";
+			throw std::runtime_error(s.c_str());
+		}
+		memcpy(dest,data_+pos_,n);
+		pos_ += n;
+	}
+
+	size_t position() const { return pos_; }
+
+	void seek(size_t pos) { pos_ = pos; }
+
+	bool end() const { return (pos_>=size_); }
+
+private:
+
+	const char* data_;
+	size_t size_;
+	size_t pos_;
+}; // class IoBinaryBuffer
+
+template<typename T>
+void binaryWrite(std::string& buf,const T& x)
+{
+	buf.append(reinterpret_cast<const char*>(&x),sizeof(T));
+}
+
+template<typename T>
+void binaryRead(IoBinaryBuffer& buf,T& x)
+{
+	buf.get(&x,sizeof(T));
+}
+
+inline void binaryWrite(std::string& buf,const std::string& x)
+{
+	size_t n = x.size();
+	binaryWrite(buf,n);
+	buf.append(x);
+}
+
+inline void binaryRead(IoBinaryBuffer& buf,std::string& x)
+{
+	size_t n = 0;
+	binaryRead(buf,n);
+	x.resize(n);
+	if (n>0) buf.get(&(x[0]),n);
+}
+
+template<typename T1,typename T2>
+void binaryWrite(std::string& buf,const std::pair<T1,T2>& x)
+{
+	binaryWrite(buf,x.first);
+	binaryWrite(buf,x.second);
+}
+
+template<typename T1,typename T2>
+void binaryRead(IoBinaryBuffer& buf,std::pair<T1,T2>& x)
+{
+	binaryRead(buf,x.first);
+	binaryRead(buf,x.second);
+}
+
+template<typename T>
+void binaryWrite(std::string& buf,const std::vector<T>& x)
+{
+	size_t n = x.size();
+	binaryWrite(buf,n);
+	for (size_t i=0;i<n;i++) binaryWrite(buf,x[i]);
+}
+
+template<typename T>
+void binaryRead(IoBinaryBuffer& buf,std::vector<T>& x)
+{
+	size_t n = 0;
+	binaryRead(buf,n);
+	x.resize(n);
+	for (size_t i=0;i<n;i++) binaryRead(buf,x[i]);
+}
+
+//! vectors of plain numbers are dumped in one piece
+template<typename T>
+void binaryWriteRaw(std::string& buf,const std::vector<T>& x)
+{
+	size_t n = x.size();
+	binaryWrite(buf,n);
+	if (n>0) buf.append(reinterpret_cast<const char*>(&(x[0])),n*sizeof(T));
+}
+
+template<typename T>
+void binaryReadRaw(IoBinaryBuffer& buf,std::vector<T>& x)
+{
+	size_t n = 0;
+	binaryRead(buf,n);
+	x.resize(n);
+	if (n>0) buf.get(&(x[0]),n*sizeof(T));
+}
+
+inline void binaryWrite(std::string& buf,const std::vector<size_t>& x) { binaryWriteRaw(buf,x); }
+
+inline void binaryRead(IoBinaryBuffer& buf,std::vector<size_t>& x) { binaryReadRaw(buf,x); }
+
+inline void binaryWrite(std::string& buf,const std::vector<int>& x) { binaryWriteRaw(buf,x); }
+
+inline void binaryRead(IoBinaryBuffer& buf,std::vector<int>& x) { binaryReadRaw(buf,x); }
+
+inline void binaryWrite(std::string& buf,const std::vector<double>& x) { binaryWriteRaw(buf,x); }
+
+inline void binaryRead(IoBinaryBuffer& buf,std::vector<double>& x) { binaryReadRaw(buf,x); }
+
+inline void binaryWrite(std::string& buf,const std::vector<std::complex<double> >& x)
+{
+	binaryWriteRaw(buf,x);
+}
+
+inline void binaryRead(IoBinaryBuffer& buf,std::vector<std::complex<double> >& x)
+{
+	binaryReadRaw(buf,x);
+}
+
+//! rows, columns, then the row pointer, column and value arrays
+template<typename T>
+void binaryWrite(std::string& buf,const PsimagLite::CrsMatrix<T>& x)
+{
+	size_t rows = x.row();
+	size_t cols = x.col();
+	binaryWrite(buf,rows);
+	binaryWrite(buf,cols);
+	size_t nonzero = (rows>0) ? x.getRowPtr(rows) : 0;
+	std::vector<int> rowptr(rows+1,0);
+	std::vector<int> colind(nonzero);
+	std::vector<T> values(nonzero);
+	for (size_t i=0;i<rows;i++) {
+		rowptr[i] = x.getRowPtr(i);
+		for (int k=x.getRowPtr(i);k<x.getRowPtr(i+1);k++) {
+			colind[k] = x.getCol(k);
+			values[k] = x.getValue(k);
+		}
+	}
+	rowptr[rows] = nonzero;
+	binaryWriteRaw(buf,rowptr);
+	binaryWriteRaw(buf,colind);
+	binaryWriteRaw(buf,values);
+}
+
+template<typename T>
+void binaryRead(IoBinaryBuffer& buf,PsimagLite::CrsMatrix<T>& x)
+{
+	size_t rows = 0;
+	size_t cols = 0;
+	binaryRead(buf,rows);
+	binaryRead(buf,cols);
+	std::vector<int> rowptr;
+	std::vector<int> colind;
+	std::vector<T> values;
+	binaryReadRaw(buf,rowptr);
+	binaryReadRaw(buf,colind);
+	binaryReadRaw(buf,values);
+	if (rows==0) {
+		x = PsimagLite::CrsMatrix<T>();
+		return;
+	}
+	x.resize(rows,cols);
+	for (size_t i=0;i<rows;i++) {
+		x.setRow(i,rowptr[i]);
+		for (int k=rowptr[i];k<rowptr[i+1];k++) {
+			x.pushCol(colind[k]);
+			x.pushValue(values[k]);
+		}
+	}
+	x.setRow(rows,rowptr[rows]);
+	x.checkValidity();
+}
+
+// dense matrices: rows, columns, then the elements row by row
+template<typename T>
+void binaryWrite(std::string& buf,const PsimagLite::Matrix<T>& x)
+{
+	binaryWrite(buf,x.n_row());
+	binaryWrite(buf,x.n_col());
+	for (size_t i=0;i<x.n_row();i++)
+		for (size_t j=0;j<x.n_col();j++)
+			binaryWrite(buf,x(i,j));
+}
+
+template<typename T>
+void binaryRead(IoBinaryBuffer& buf,PsimagLite::Matrix<T>& x)
+{
+	size_t rows = 0;
+	size_t cols = 0;
+	binaryRead(buf,rows);
+	binaryRead(buf,cols);
+	x.reset(rows,cols);
+	for (size_t i=0;i<rows;i++)
+		for (size_t j=0;j<cols;j++)
+			binaryRead(buf,x(i,j));
+}
+
+class IoBinary {
+
+	enum {LINE,DATA};
+
+public:
+
+	//! 32-bit FNV-1a, used as a checksum of records
+	static unsigned int checksum(const char* data,size_t size)
+	{
+		unsigned int h = 2166136261u;
+		for (size_t i=0;i<size;i++) {
+			h ^= static_cast<unsigned char>(data[i]);
+			h *= 16777619u;
+		}
+		return h;
+	}
+
+	static bool littleEndian()
+	{
+		unsigned int one = 1;
+		return (*reinterpret_cast<unsigned char*>(&one)==1);
+	}
+
+	// The records of the binary files (see DiskStack and IoBinaryFile) are
+	// a length, a checksum of the bytes and the bytes
+
+	static size_t recordHeaderSize() { return sizeof(size_t) + sizeof(unsigned int); }
+
+	//! writes a record at the current position of os; returns its offset
+	static size_t writeRecord(std::ostream& os,const std::string& bytes)
+	{
+		size_t offset = os.tellp();
+		size_t n = bytes.size();
+		unsigned int sum = checksum(bytes.data(),n);
+		os.write(reinterpret_cast<const char*>(&n),sizeof(size_t));
+		os.write(reinterpret_cast<const char*>(&sum),sizeof(unsigned int));
+		os.write(bytes.data(),n);
+		return offset;
+	}
+
+	//! reads the record at offset of is into bytes, and its checksum as stored
+	//! into sum; returns false if the record could not be read
+	static bool readRecord(std::istream& is,size_t offset,std::string& bytes,unsigned int& sum)
+	{
+		size_t n = 0;
+		is.clear();
+		is.seekg(offset);
+		is.read(reinterpret_cast<char*>(&n),sizeof(size_t));
+		is.read(reinterpret_cast<char*>(&sum),sizeof(unsigned int));
+		if (!is) return false;
+		bytes.resize(n);
+		if (n>0) is.read(&(bytes[0]),n);
+		return !is.fail();
+	}
+
+	//! the record at offset of the size bytes at data, in place: returns its bytes,
+	//! their number in n and the checksum as stored in sum, or 0 if it goes past size
+	static const char* record(const char* data,size_t size,size_t offset,size_t& n,unsigned int& sum)
+	{
+		if (offset+recordHeaderSize()>size) return 0;
+		memcpy(&n,data+offset,sizeof(size_t));
+		memcpy(&sum,data+offset+sizeof(size_t),sizeof(unsigned int));
+		if (n>size-offset-recordHeaderSize()) return 0;
+		return data + offset + recordHeaderSize();
+	}
+
+	class Out {
+
+	public:
+
+		Out()
+		{
+			if (!littleEndian()) {
+				std::string s(__FILE__);
+				s += ": binary format needs a little endian host\n";
+				throw std::runtime_error(s.c_str());
+			}
+		}
+
+		void printline(const std::string& s)
+		{
+			size_t l = s.length();
+			if (l>0 && s[l-1]=='\n') l--;
+			record(LINE,s.substr(0,l),"");
+		}
+
+		void print(const std::string& s) { printline(s); }
+
+		template<typename X>
+		void printVector(const X& x,const std::string& label)
+		{
+			std::string payload;
+			binaryWrite(payload,x);
+			record(DATA,label,payload);
+		}
+
+		template<typename X>
+		void printMatrix(const X& x,const std::string& label)
+		{
+			printVector(x,label);
+		}
+
+		const std::string& buffer() const { return buffer_; }
+
+		void clear() { buffer_ = ""; }
+
+	private:
+
+		void record(int kind,const std::string& label,const std::string& payload)
+		{
+			binaryWrite(buffer_,kind);
+			binaryWrite(buffer_,label);
+			binaryWrite(buffer_,payload);
+		}
+
+		std::string buffer_;
+	}; // class Out
+
+	class In {
+
+	public:
+
+		In(const char* data,size_t size) : buf_(data,size) {}
+
+		//! label is a prefix of the line, as in "#NAME="
+		std::pair<std::string,size_t> advance(const std::string& label,size_t counter=0)
+		{
+			size_t found = 0;
+			while (!buf_.end()) {
+				std::string line = next(LINE,label);
+				if (line=="") break;
+				if (found==counter) return std::pair<std::string,size_t>(line,buf_.position());
+				found++;
+			}
+			throw std::runtime_error(notFound(label).c_str());
+		}
+
+		template<typename X>
+		void readline(X& x,const std::string& label)
+		{
+			std::string line = next(LINE,label);
+			if (line=="") throw std::runtime_error(notFound(label).c_str());
+			std::istringstream is(line.substr(label.length()));
+			is>>x;
+		}
+
+		//! with lastInstance nonzero reads the last matching line
+		//! of the buffer and leaves the cursor after it
+		template<typename X>
+		void readline(X& x,const std::string& label,size_t lastInstance)
+		{
+			if (!lastInstance) {
+				readline(x,label);
+				return;
+			}
+			std::string found;
+			size_t pos = 0;
+			while (!buf_.end()) {
+				std::string line = next(LINE,label);
+				if (line=="") break;
+				found = line;
+				pos = buf_.position();
+			}
+			if (found=="") throw std::runtime_error(notFound(label).c_str());
+			buf_.seek(pos);
+			std::istringstream is(found.substr(label.length()));
+			is>>x;
+		}
+
+		template<typename X>
+		void read(X& x,const std::string& label)
+		{
+			if (next(DATA,label)=="") throw std::runtime_error(notFound(label).c_str());
+			binaryRead(buf_,x);
+			buf_.seek(payloadEnd_);
+		}
+
+		template<typename X>
+		void readMatrix(X& x,const std::string& label)
+		{
+			read(x,label);
+		}
+
+		void close() {}
+
+	private:
+
+		//! moves past the next record of this kind and label,
+		//! returns its label, or "" if none; for data records the
+		//! cursor is left at the payload
+		std::string next(int kind,const std::string& label)
+		{
+			while (!buf_.end()) {
+				int k = 0;
+				std::string l;
+				size_t n = 0;
+				binaryRead(buf_,k);
+				binaryRead(buf_,l);
+				binaryRead(buf_,n);
+				payloadEnd_ = buf_.position() + n;
+				// lines match by prefix, data by the whole label
+				bool match = (k==kind && ((kind==LINE) ?
+				              l.substr(0,label.length())==label : l==label));
+				if (match && kind==DATA) return l;
+				buf_.seek(payloadEnd_);
+				if (match) return l;
+			}
+			return "";
+		}
+
+		std::string notFound(const std::string& label) const
+		{
+			std::string s(__FILE__);
+			s += ": label " + label + " not found in binary record\n";
+			return s;
+		}
+
+		IoBinaryBuffer buf_;
+		size_t payloadEnd_;
+	}; // class In
+}; // class IoBinary
+} // namespace Dmrg
+
+/*@}*/
+#endif // IO_BINARY_H
@@ -0,0 +1,427 @@
+/*
+Copyright (c) 2012, UT-Battelle, LLC
+All rights reserved
+
+[DMRG++, Version 2.0.0]
+[by G.A., Oak Ridge National Laboratory]
+
+UT Battelle Open Source Software License 11242008
+
+OPEN SOURCE LICENSE
+
+Subject to the conditions of this License, each
+contributor to this software hereby grants, free of
+charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), a
+perpetual, worldwide, non-exclusive, no-charge,
+royalty-free, irrevocable copyright license to use, copy,
+modify, merge, publish, distribute, and/or sublicense
+copies of the Software.
+
+1. Redistributions of Software must retain the above
+copyright and license notices, this list of conditions,
+and the following disclaimer.  Changes or modifications
+to, or derivative works of, the Software should be noted
+with comments and the contributor and organization's
+name.
+
+2. Neither the names of UT-Battelle, LLC or the
+Department of Energy nor the names of the Software
+contributors may be used to endorse or promote products
+derived from this software without specific prior written
+permission of UT-Battelle.
+
+3. The software and the end-user documentation included
+with the redistribution, with or without modification,
+must include the following acknowledgment:
+
+"This product includes software produced by UT-Battelle,
+LLC under Contract No. DE-AC05-00OR22725  with the
+Department of Energy."
+
+*********************************************************
+DISCLAIMER
+
+THE SOFTWARE IS SUPPLIED BY THE COPYRIGHT HOLDERS AND
+CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER, CONTRIBUTORS, UNITED STATES GOVERNMENT,
+OR THE UNITED STATES DEPARTMENT OF ENERGY BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+DAMAGE.
+
+NEITHER THE UNITED STATES GOVERNMENT, NOR THE UNITED
+STATES DEPARTMENT OF ENERGY, NOR THE COPYRIGHT OWNER, NOR
+ANY OF THEIR EMPLOYEES, REPRESENTS THAT THE USE OF ANY
+INFORMATION, DATA, APPARATUS, PRODUCT, OR PROCESS
+DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
+
+*********************************************************
+
+
+*/
+// END LICENSE BLOCK
+/** \ingroup DMRG */
+/*@{*/
+/*! \file IoBinaryFile.h
+ *
+ *  A binary data file for what DmrgSolver serializes at each finite
+ *  step, that is, the DmrgSerializer and the target's save.
+ *
+ *  The file has a header, one record per step (length, checksum and
+ *  the IoBinary bytes of the step) and a footer with the byte offset
+ *  of each record, followed by the offset of the footer and a trailer.
+ *  The reader maps the file into memory and reads each step in place;
+ *  if the run was interrupted and there is no footer, it recovers the
+ *  offsets by walking the records from the header
+ *
+ */
+
+#ifndef IO_BINARY_FILE_H
+#define IO_BINARY_FILE_H
+
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "IoBinary.h"
+#include "TypeToString.h" // in PsimagLite
+
+namespace Dmrg {
+
+class IoBinaryFile {
+
+	static const size_t TAG_SIZE = 8;
+
+	static const char* header() { return "DMRGDAT1"; }
+
+	static const char* trailer() { return "DMRGIDX1"; }
+
+	static void error(const std::string& what)
+	{
+		std::string s(__FILE__);
+		s += ": IoBinaryFile: " + what + "\n";
+		throw std::runtime_error(s.c_str());
+	}
+
+public:
+
+	//! the binary data file that goes with the text one
+	static std::string name(const std::string& textFile)
+	{
+		return textFile + ".bin";
+	}
+
+	class Out {
+
+	public:
+
+		Out() : rank_(0),open_(false) {}
+
+		~Out() { close(); }
+
+		void open(const std::string& filename,size_t rank)
+		{
+			filename_ = filename;
+			rank_ = rank;
+			open_ = true;
+			if (rank_>0) return;
+			fout_.open(filename_.c_str(),std::ios::binary | std::ios::trunc);
+			if (!fout_ || !IoBinary::littleEndian())
+				error("cannot write " + filename_);
+			fout_.write(header(),TAG_SIZE);
+		}
+
+		bool isOpen() const { return open_; }
+
+		void printline(const std::string& s) { step_.printline(s); }
+
+		void print(const std::string& s) { step_.print(s); }
+
+		template<typename X>
+		void print(const std::string& label,const X& x)
+		{
+			std::ostringstream os;
+			os<<label<<x;
+			step_.printline(os.str());
+		}
+
+		template<typename X>
+		void printVector(const X& x,const std::string& label)
+		{
+			step_.printVector(x,label);
+		}
+
+		template<typename X>
+		void printMatrix(const X& x,const std::string& label)
+		{
+			step_.printMatrix(x,label);
+		}
+
+		//! writes what was printed since the last call as one step
+		void endStep()
+		{
+			if (rank_==0) offsets_.push_back(writeRecord(step_.buffer()));
+			step_.clear();
+		}
+
+		void close()
+		{
+			if (!open_) return;
+			open_ = false;
+			if (rank_>0) return;
+			if (step_.buffer().size()>0) endStep();
+			std::string bytes;
+			binaryWrite(bytes,offsets_);
+			size_t footer = writeRecord(bytes);
+			fout_.write(reinterpret_cast<const char*>(&footer),sizeof(size_t));
+			fout_.write(trailer(),TAG_SIZE);
+			fout_.close();
+		}
+
+	private:
+
+		Out(const Out&);
+
+		Out& operator=(const Out&);
+
+		size_t writeRecord(const std::string& bytes)
+		{
+			size_t offset = IoBinary::writeRecord(fout_,bytes);
+			// so that an interrupted run leaves whole steps behind
+			fout_.flush();
+			if (!fout_) error("writing to " + filename_ + " failed");
+			return offset;
+		}
+
+		std::string filename_;
+		size_t rank_;
+		bool open_;
+		std::ofstream fout_;
+		IoBinary::Out step_;
+		std::vector<size_t> offsets_;
+	}; // class Out
+
+	//! Reads steps by index with step(i), or as a stream with the
+	//! interface of PsimagLite::IoSimple::In; a stream read that does
+	//! not find its label in what is left of the current step moves on
+	//! to the next step, as a forward search in the text file would
+	class In {
+
+	public:
+
+		In(const std::string& filename)
+		: filename_(filename),data_(0),size_(0),current_(0),reader_(0,0)
+		{
+			map();
+			readIndex();
+			if (offsets_.size()>0) reader_ = step(0);
+		}
+
+		~In()
+		{
+			if (data_) munmap(const_cast<char*>(data_),size_);
+		}
+
+		//! number of steps in the file
+		size_t size() const { return offsets_.size(); }
+
+		//! a reader over step i, in place in the mapped file
+		IoBinary::In step(size_t i)
+		{
+			if (i>=offsets_.size())
+				error("no step " + ttos(i) + " in " + filename_);
+			size_t n = 0;
+			unsigned int sum = 0;
+			const char* bytes = record(offsets_[i],n,sum);
+			if (!verified_[i]) {
+				if (IoBinary::checksum(bytes,n)!=sum)
+					error("checksum mismatch in step " + ttos(i) + " of " + filename_);
+				verified_[i] = true;
+			}
+			return IoBinary::In(bytes,n);
+		}
+
+		//! bytes taken by step i in the file
+		size_t stepBytes(size_t i) const
+		{
+			if (i>=offsets_.size())
+				error("no step " + ttos(i) + " in " + filename_);
+			size_t n = 0;
+			unsigned int sum = 0;
+			record(offsets_[i],n,sum);
+			return n;
+		}
+
+		//! stream reads continue from the start of step i,
+		//! or find no more data if i is the number of steps
+		void seek(size_t i)
+		{
+			reader_ = (i==offsets_.size()) ? IoBinary::In(0,0) : step(i);
+			current_ = i;
+		}
+
+		size_t currentStep() const { return current_; }
+
+		void rewind()
+		{
+			if (offsets_.size()>0) seek(0);
+		}
+
+		std::pair<std::string,size_t> advance(const std::string& label,size_t counter=0)
+		{
+			while (true) {
+				try {
+					return reader_.advance(label,counter);
+				} catch (std::runtime_error&) {
+					if (!nextStep()) throw;
+				}
+			}
+		}
+
+		template<typename X>
+		void readline(X& x,const std::string& label)
+		{
+			while (true) {
+				try {
+					reader_.readline(x,label);
+					return;
+				} catch (std::runtime_error&) {
+					if (!nextStep()) throw;
+				}
+			}
+		}
+
+		//! with lastInstance nonzero reads the last matching line
+		//! of the file, searching the steps from the last one
+		template<typename X>
+		void readline(X& x,const std::string& label,size_t lastInstance)
+		{
+			if (!lastInstance) {
+				readline(x,label);
+				return;
+			}
+			for (size_t i=offsets_.size();i>current_;i--) {
+				IoBinary::In reader = step(i-1);
+				try {
+					reader.readline(x,label,lastInstance);
+				} catch (std::runtime_error&) {
+					continue;
+				}
+				reader_ = reader;
+				current_ = i-1;
+				return;
+			}
+			error("label " + label + " not found in " + filename_);
+		}
+
+		template<typename X>
+		void read(X& x,const std::string& label)
+		{
+			while (true) {
+				try {
+					reader_.read(x,label);
+					return;
+				} catch (std::runtime_error&) {
+					if (!nextStep()) throw;
+				}
+			}
+		}
+
+		template<typename X>
+		void readMatrix(X& x,const std::string& label)
+		{
+			read(x,label);
+		}
+
+		void close() {}
+
+	private:
+
+		In(const In&);
+
+		In& operator=(const In&);
+
+		bool nextStep()
+		{
+			if (current_+1>=offsets_.size()) return false;
+			seek(current_+1);
+			return true;
+		}
+
+		void map()
+		{
+			int fd = ::open(filename_.c_str(),O_RDONLY);
+			if (fd<0) error("cannot open " + filename_);
+			struct stat st;
+			if (fstat(fd,&st)!=0) {
+				::close(fd);
+				error("cannot stat " + filename_);
+			}
+			size_ = st.st_size;
+			void* p = (size_>0) ? mmap(0,size_,PROT_READ,MAP_SHARED,fd,0) : MAP_FAILED;
+			::close(fd);
+			if (p==MAP_FAILED) error("cannot map " + filename_);
+			data_ = static_cast<const char*>(p);
+			if (size_<TAG_SIZE || memcmp(data_,header(),TAG_SIZE)!=0)
+				error(filename_ + " is not a binary data file");
+		}
+
+		void readIndex()
+		{
+			size_t tail = TAG_SIZE + sizeof(size_t);
+			if (size_>=TAG_SIZE+tail &&
+			    memcmp(data_+size_-TAG_SIZE,trailer(),TAG_SIZE)==0) {
+				size_t footer = 0;
+				memcpy(&footer,data_+size_-tail,sizeof(size_t));
+				size_t n = 0;
+				unsigned int sum = 0;
+				const char* bytes = record(footer,n,sum);
+				if (IoBinary::checksum(bytes,n)!=sum)
+					error("checksum mismatch in the index of " + filename_);
+				IoBinaryBuffer buf(bytes,n);
+				binaryRead(buf,offsets_);
+			} else {
+				size_t pos = TAG_SIZE;
+				size_t n = 0;
+				unsigned int sum = 0;
+				while (IoBinary::record(data_,size_,pos,n,sum)) {
+					offsets_.push_back(pos);
+					pos += IoBinary::recordHeaderSize() + n;
+				}
+				std::cerr<<"IoBinaryFile: "<<filename_<<" has no index, ";
+				std::cerr<<offsets_.size()<<" whole steps recovered\n";
+			}
+			verified_.resize(offsets_.size(),false);
+		}
+
+		const char* record(size_t offset,size_t& n,unsigned int& sum) const
+		{
+			const char* bytes = IoBinary::record(data_,size_,offset,n,sum);
+			if (!bytes) error("record past the end of " + filename_);
+			return bytes;
+		}
+
+		std::string filename_;
+		const char* data_;
+		size_t size_;
+		size_t current_;
+		IoBinary::In reader_;
+		std::vector<size_t> offsets_;
+		std::vector<bool> verified_;
+	}; // class In
+}; // class IoBinaryFile
+} // namespace Dmrg
+
+/*@}*/
+#endif // IO_BINARY_FILE_H
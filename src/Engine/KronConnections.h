@@ -75,6 +75,9 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 
 /*! \file KronConnections.h
  *
+ *  One thread per group of output patches; for each output patch p=(ip,jp)
+ *  W_p = HL(ip,ip) V_p + V_p HR(jp,jp)^T + sum_c v_c A_c(ip,i) V_(i,j) B_c(jp,j)^T
+ *  with all blocks dense and all products done by GEMM
  *
  */
 
@@ -82,6 +85,7 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #define KRON_CONNECTIONS_H
 
 #include "Matrix.h"
+#include "BLAS.h"
 
 namespace Dmrg {
 
@@ -90,8 +94,8 @@ class KronConnections {
 
 	typedef typename InitKronType::SparseMatrixType SparseMatrixType;
 	typedef typename SparseMatrixType::value_type ComplexOrRealType;
-	typedef PsimagLite::Matrix<ComplexOrRealType> MatrixType;
 	typedef typename InitKronType::ArrayOfMatStructType ArrayOfMatStructType;
+	typedef typename ArrayOfMatStructType::MatrixType MatrixType;
 	typedef typename InitKronType::GenIjPatchType GenIjPatchType;
 	typedef typename InitKronType::GenGroupType GenGroupType;
 
@@ -99,88 +103,113 @@ public:
 
 	typedef typename InitKronType::RealType RealType;
 
-	KronConnections(const InitKronType& initKron,MatrixType& W,const MatrixType& V)
-	: initKron_(initKron),W_(W),V_(V)
+	//! W and V are patch-ordered, see InitKron::patchOffset
+	KronConnections(const InitKronType& initKron,
+	                std::vector<ComplexOrRealType>& W,
+	                const std::vector<ComplexOrRealType>& V)
+	: initKron_(initKron),W_(W),V_(V),maxPatch_(0)
 	{
+		maxPatch_ = maxGroup(initKron_.istartLeft())*maxGroup(initKron_.istartRight());
 	}
 
-	//! ATTENTION: ONLY VALID ON X86 AND X86_64 WHERE += IS ATOMIC
+	//! Each output patch belongs to exactly one thread, so no locking is needed
 	void thread_function_(size_t threadNum,size_t blockSize,size_t total,pthread_mutex_t* myMutex)
 	{
 		size_t nC = initKron_.connections();
 		const GenGroupType& istartLeft = initKron_.istartLeft();
 		const GenGroupType& istartRight = initKron_.istartRight();
-		MatrixType intermediate(W_.n_row(),W_.n_col());
+		std::vector<ComplexOrRealType> intermediate(maxPatch_);
 
-//		std::cerr<<"threadNum="<<threadNum<<" blockSize="<<blockSize<<" total="<<total<<"\n";
 		for (size_t p=0;p<blockSize;p++) {
 			size_t outPatch = threadNum * blockSize + p;
 			if (outPatch>=total) break;
-			for (size_t inPatch=0;inPatch<total;inPatch++) {
-				for (size_t ic=0;ic<nC;ic++) {
-					const ComplexOrRealType& val = initKron_.value(ic);
-					const ArrayOfMatStructType& xiStruct = initKron_.xc(ic);
-					const ArrayOfMatStructType& yiStruct = initKron_.yc(ic);
-
-					size_t i = initKron_.patch(GenIjPatchType::LEFT,inPatch);
-					size_t j = initKron_.patch(GenIjPatchType::RIGHT,inPatch);
-
-					size_t ip = initKron_.patch(GenIjPatchType::LEFT,outPatch);
-					size_t jp = initKron_.patch(GenIjPatchType::RIGHT,outPatch);
-
-					size_t i1 = istartLeft(i);
-//					size_t i2 = istartLeft(i+1);
-
-					size_t j1 = istartRight(j);
-					size_t j2 = istartRight(j+1);
-
-					size_t ip1 = istartLeft(ip);
-//					size_t ip2 = istartLeft(ip+1);
-
-					size_t jp1 = istartRight(jp);
-//					size_t jp2 = istartLeft(jp+1);
-
-					const SparseMatrixType& tmp1 =  xiStruct(ip,i);
-					const SparseMatrixType& tmp2 =  yiStruct(j,jp);
-
-					size_t colsize = j2 -j1;
-					for (size_t mr2=0;mr2<colsize;mr2++)
-						for (size_t mr=0;mr<tmp1.row();mr++)
-							intermediate(mr,mr2)=0.0;
-
-					for (size_t mr=0;mr<tmp1.row();mr++) {
-						for (int k3=tmp1.getRowPtr(mr);k3<tmp1.getRowPtr(mr+1);k3++) {
-							size_t col3 = tmp1.getCol(k3)+i1;
-							ComplexOrRealType valtmp = val * tmp1.getValue(k3);
-							for (size_t mr2=j1;mr2<j2;mr2++) {
-								intermediate(mr,mr2-j1) += valtmp * V_(col3,mr2);
-							}
-						}
-					}
-					for (size_t mr2=0;mr2<colsize;mr2++) {
-						size_t start = tmp2.getRowPtr(mr2);
-						size_t end = tmp2.getRowPtr(mr2+1);
-						for (size_t k4=start;k4<end;k4++) {
-							ComplexOrRealType value1 = tmp2.getValue(k4);
-							size_t col4 = tmp2.getCol(k4)+jp1;
-							for (size_t mr=0;mr<tmp1.row();mr++) {
-								W_(mr+ip1,col4) += intermediate(mr,mr2) * value1;
-							}
-						}
+
+			size_t ip = initKron_.patch(GenIjPatchType::LEFT,outPatch);
+			size_t jp = initKron_.patch(GenIjPatchType::RIGHT,outPatch);
+			int nlp = istartLeft(ip+1) - istartLeft(ip);
+			int nrp = istartRight(jp+1) - istartRight(jp);
+			ComplexOrRealType* w = &(W_[initKron_.patchOffset(outPatch)]);
+
+			computeLeft(w,ip,jp,nlp,nrp);
+			computeRight(w,ip,jp,nlp,nrp);
+
+			for (size_t ic=0;ic<nC;ic++) {
+				const ComplexOrRealType& val = initKron_.value(ic);
+				const ArrayOfMatStructType& xiStruct = initKron_.xc(ic);
+				const ArrayOfMatStructType& yiStruct = initKron_.yc(ic);
+
+				for (size_t ka=0;ka<xiStruct.blocks(ip);ka++) {
+					size_t i = xiStruct.col(ip,ka);
+					const MatrixType& tmp1 = xiStruct(ip,ka);
+					int nli = istartLeft(i+1) - istartLeft(i);
+
+					for (size_t kb=0;kb<yiStruct.blocks(jp);kb++) {
+						size_t j = yiStruct.col(jp,kb);
+						int inPatch = initKron_.patch(i,j);
+						if (inPatch<0) continue;
+						const MatrixType& tmp2 = yiStruct(jp,kb);
+						int nrj = istartRight(j+1) - istartRight(j);
+						const ComplexOrRealType* v = &(V_[initKron_.patchOffset(inPatch)]);
+
+						// intermediate = A(ip,i) V_(i,j)
+						psimag::BLAS::GEMM('N','N',nlp,nrj,nli,1.0,&(tmp1(0,0)),nlp,
+						                   v,nli,0.0,&(intermediate[0]),nlp);
+						// W_p += val intermediate B(jp,j)^T
+						psimag::BLAS::GEMM('N','T',nlp,nrp,nrj,val,&(intermediate[0]),nlp,
+						                   &(tmp2(0,0)),nrp,1.0,w,nlp);
 					}
 				}
 			}
 		}
+	}
+
+private:
+
+	static size_t maxGroup(const GenGroupType& istart)
+	{
+		size_t n = 0;
+		for (size_t i=0;i+1<istart.size();i++)
+			if (istart(i+1)-istart(i)>n) n = istart(i+1)-istart(i);
+		return n;
+	}
 
+	// W_p += HL(ip,ip) V_p
+	void computeLeft(ComplexOrRealType* w,size_t ip,size_t jp,int nlp,int nrp) const
+	{
+		const ArrayOfMatStructType& alStruct = initKron_.aL();
+		for (size_t k=0;k<alStruct.blocks(ip);k++) {
+			size_t i = alStruct.col(ip,k);
+			int inPatch = initKron_.patch(i,jp);
+			if (inPatch<0) continue;
+			const ComplexOrRealType* v = &(V_[initKron_.patchOffset(inPatch)]);
+			int nli = initKron_.istartLeft()(i+1) - initKron_.istartLeft()(i);
+			psimag::BLAS::GEMM('N','N',nlp,nrp,nli,1.0,&(alStruct(ip,k)(0,0)),nlp,
+			                   v,nli,1.0,w,nlp);
+		}
+	}
 
+	// W_p += V_p HR(jp,jp)^T
+	void computeRight(ComplexOrRealType* w,size_t ip,size_t jp,int nlp,int nrp) const
+	{
+		const ArrayOfMatStructType& arStruct = initKron_.aR();
+		for (size_t k=0;k<arStruct.blocks(jp);k++) {
+			size_t j = arStruct.col(jp,k);
+			int inPatch = initKron_.patch(ip,j);
+			if (inPatch<0) continue;
+			const ComplexOrRealType* v = &(V_[initKron_.patchOffset(inPatch)]);
+			int nrj = initKron_.istartRight()(j+1) - initKron_.istartRight()(j);
+			psimag::BLAS::GEMM('N','T',nlp,nrp,nrj,1.0,v,nlp,
+			                   &(arStruct(jp,k)(0,0)),nrp,1.0,w,nlp);
+		}
 	}
 
 	const InitKronType& initKron_;
-	MatrixType& W_;
-	const MatrixType& V_;
+	std::vector<ComplexOrRealType>& W_;
+	const std::vector<ComplexOrRealType>& V_;
+	size_t maxPatch_;
 }; //class KronConnections
 
-} // namespace PsimagLite
+} // namespace Dmrg
 
 /*@}*/
 
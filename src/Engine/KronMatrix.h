@@ -75,6 +75,7 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 
 /*! \file KronMatrix.h
  *
+ *  y += H x for one symmetry sector, with H in Kronecker form (see InitKron)
  *
  */
 
@@ -91,137 +92,47 @@ class KronMatrix {
 
 	typedef typename InitKronType::SparseMatrixType SparseMatrixType;
 	typedef typename SparseMatrixType::value_type ComplexOrRealType;
-	typedef PsimagLite::Matrix<ComplexOrRealType> MatrixType;
-	typedef typename InitKronType::ArrayOfMatStructType ArrayOfMatStructType;
-	typedef typename InitKronType::GenIjPatchType GenIjPatchType;
-	typedef typename InitKronType::GenGroupType GenGroupType;
-	typedef typename InitKronType::ModelHelperType::ConcurrencyType ConcurrencyType;
+	typedef typename InitKronType::ConcurrencyType ConcurrencyType;
+	typedef KronConnections<InitKronType> KronConnectionsType;
+	typedef typename InitKronType::template ParallelConnectionsInner<KronConnectionsType> ParallelConnectionsInnerType;
+	typedef typename ParallelConnectionsInnerType::Type ParallelConnectionsInnerTypeType;
 
 public:
 
 	KronMatrix(const InitKronType& initKron)
-	: initKron_(initKron)
+	: initKron_(initKron),V_(initKron.size()),W_(initKron.size())
 	{
-		std::cout<<"KronMatrix: EXPERIMENTAL: preparation done for size="<<initKron.size()<<"\n";
 	}
 
 	void matrixVectorProduct(std::vector<ComplexOrRealType>& vout,
 				 const std::vector<ComplexOrRealType>& vin) const
 	{
-		const std::vector<size_t>& permInverse = initKron_.lrs().super().permutationInverse();
-		const std::vector<size_t>& perm = initKron_.lrs().super().permutationVector();
-		const SparseMatrixType& left = initKron_.lrs().left().hamiltonian();
-		const SparseMatrixType& right = initKron_.lrs().right().hamiltonian();
-		size_t nl = left.row();
-		size_t nr = right.row();
 		size_t nq = initKron_.size();
-		size_t offset = initKron_.offset();
-
-		MatrixType V(nl,nr);
-		for (size_t i=0;i<nl;i++) {
-			for (size_t j=0;j<nr;j++) {
-				size_t r = permInverse[i+j*nl];
-				if (r<offset || r>=offset+nq) continue;
-				V(i,j) = vin[r-offset];
-			}
+		for (size_t r=0;r<nq;r++) {
+			V_[initKron_.patchOrdered(r)] = vin[r];
+			W_[r] = 0.0;
 		}
 
-		MatrixType W(nl,nr);
-
-		computeRight(W,V);
-		computeLeft(W,V);
-		computeConnections(W,V);
-
-		for (size_t r=0;r<vout.size();r++) {
-			div_t divresult = div(perm[r+offset],nl);
-			size_t i = divresult.rem;
-			size_t j = divresult.quot;
-			vout[r] += W(i,j);
-		}
-	}
-
-private:
-
-	void computeRight(MatrixType& W,const MatrixType& V) const
-	{
-		size_t npatches = initKron_.patch();
-		const GenGroupType& istartLeft = initKron_.istartLeft();
-		const GenGroupType& istartRight = initKron_.istartRight();
-		const ArrayOfMatStructType& artStruct = initKron_.aRt();
-
-		for (size_t ipatch = 0;ipatch<npatches;ipatch++) {
-			size_t i = initKron_.patch(GenIjPatchType::LEFT,ipatch);
-			size_t j = initKron_.patch(GenIjPatchType::RIGHT,ipatch);
-
-			size_t i1 = istartLeft(i);
-			size_t i2 = istartLeft(i+1);
-
-			size_t j1 = istartRight(j);
-			//size_t j2 = istartRight(j+1);
-
-			const SparseMatrixType& tmp = artStruct(j,j);
-			for (size_t ii=i1;ii<i2;ii++) {
-				for (size_t mr=0;mr<tmp.row();mr++) {
-					for (int kk=tmp.getRowPtr(mr);kk<tmp.getRowPtr(mr+1);kk++) {
-						size_t col = tmp.getCol(kk) + j1;
-//						if (col>=i2) continue;
-						W(ii,col) += V(ii, mr+j1) * tmp.getValue(kk);
-					}
-				}
-			}
-		}
-	}
-
-	void computeLeft(MatrixType& W,const MatrixType& V) const
-	{
-		size_t npatches = initKron_.patch();
-		const GenGroupType& istartLeft = initKron_.istartLeft();
-		const GenGroupType& istartRight = initKron_.istartRight();
-		const ArrayOfMatStructType& alStruct = initKron_.aL();
-
-		for (size_t ipatch = 0;ipatch<npatches;ipatch++) {
-			size_t i = initKron_.patch(GenIjPatchType::LEFT,ipatch);
-			size_t j = initKron_.patch(GenIjPatchType::RIGHT,ipatch);
-
-			size_t i1 = istartLeft(i);
-//			size_t i2 = istartLeft(i+1);
-
-			size_t j1 = istartRight(j);
-			size_t j2 = istartRight(j+1);
-
-			const SparseMatrixType& tmp = alStruct(i,i);
-
-			for (size_t jj=j1;jj<j2;jj++) {
-				for (size_t mr=0;mr<tmp.row();mr++) {
-					for (int kk=tmp.getRowPtr(mr);kk<tmp.getRowPtr(mr+1);kk++) {
-						size_t col = tmp.getCol(kk) + i1;
-//						if (col>=i2) continue;
-						W(mr+i1,jj) += tmp.getValue(kk) *  V(col, jj);
-					}
-				}
-			}
-		}
-	}
-
-	// ATTENTION: MPI is not supported, only pthreads
-	void computeConnections(MatrixType& W,const MatrixType& V) const
-	{
-		typedef KronConnections<InitKronType> KronConnectionsType;
-		KronConnectionsType kc(initKron_,W,V);
-		typedef typename InitKronType::template ParallelConnectionsInner<KronConnectionsType> ParallelConnectionsInnerType;
-		typedef typename ParallelConnectionsInnerType::Type ParallelConnectionsInnerTypeType;
+		KronConnectionsType kc(initKron_,W_,V_);
 		ParallelConnectionsInnerTypeType parallelConnections;
 		parallelConnections.setThreads(initKron_.numberOfThreads());
 		size_t npatches = initKron_.patch();
 		parallelConnections.loopCreate(npatches,kc,initKron_.concurrency());
-		//hc.sync(parallelConnections,concurrency_);
+		parallelConnections.reduce(W_,initKron_.concurrency());
+
+		for (size_t r=0;r<nq;r++)
+			vout[r] += W_[initKron_.patchOrdered(r)];
 	}
 
+private:
+
 	const InitKronType& initKron_;
+	mutable std::vector<ComplexOrRealType> V_;
+	mutable std::vector<ComplexOrRealType> W_;
 
 }; //class KronMatrix
 
-} // namespace PsimagLite
+} // namespace Dmrg
 
 /*@}*/
 
@@ -0,0 +1,133 @@
+/*
+Copyright (c) 2013, UT-Battelle, LLC
+All rights reserved
+
+[DMRG++, Version 2.0.0]
+[by G.A., Oak Ridge National Laboratory]
+
+UT Battelle Open Source Software License 11242008
+
+OPEN SOURCE LICENSE
+
+Subject to the conditions of this License, each
+contributor to this software hereby grants, free of
+charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), a
+perpetual, worldwide, non-exclusive, no-charge,
+royalty-free, irrevocable copyright license to use, copy,
+modify, merge, publish, distribute, and/or sublicense
+copies of the Software.
+
+1. Redistributions of Software must retain the above
+copyright and license notices, this list of conditions,
+and the following disclaimer.  Changes or modifications
+to, or derivative works of, the Software should be noted
+with comments and the contributor and organization's
+name.
+
+2. Neither the names of UT-Battelle, LLC or the
+Department of Energy nor the names of the Software
+contributors may be used to endorse or promote products
+derived from this software without specific prior written
+permission of UT-Battelle.
+
+3. The software and the end-user documentation included
+with the redistribution, with or without modification,
+must include the following acknowledgment:
+
+"This product includes software produced by UT-Battelle,
+LLC under Contract No. DE-AC05-00OR22725  with the
+Department of Energy."
+
+*********************************************************
+DISCLAIMER
+
+THE SOFTWARE IS SUPPLIED BY THE COPYRIGHT HOLDERS AND
+CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER, CONTRIBUTORS, UNITED STATES GOVERNMENT,
+OR THE UNITED STATES DEPARTMENT OF ENERGY BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+DAMAGE.
+
+NEITHER THE UNITED STATES GOVERNMENT, NOR THE UNITED
+STATES DEPARTMENT OF ENERGY, NOR THE COPYRIGHT OWNER, NOR
+ANY OF THEIR EMPLOYEES, REPRESENTS THAT THE USE OF ANY
+INFORMATION, DATA, APPARATUS, PRODUCT, OR PROCESS
+DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
+
+*********************************************************
+
+
+*/
+// END LICENSE BLOCK
+/** \ingroup DMRG */
+/*@{*/
+/*! \file KrylovWorkspace.h
+ *
+ *  Storage for the vectors of a Krylov solver that outlives the solver,
+ *  so that consecutive DMRG steps, whose sectors have similar sizes,
+ *  reuse the same buffers instead of allocating and zeroing new ones.
+ *  A buffer is never shrunk, so it keeps the capacity of the largest
+ *  sector seen so far. Only BlockLanczosSolver (option useBlockLanczos)
+ *  uses it: the LanczosSolver and DavidsonSolver of PsimagLite allocate
+ *  their own vectors
+ *
+ */
+
+#ifndef KRYLOV_WORKSPACE_H
+#define KRYLOV_WORKSPACE_H
+
+#include <vector>
+#include <cassert>
+
+namespace Dmrg {
+
+template<typename ComplexOrRealType>
+class KrylovWorkspace {
+
+public:
+
+	typedef std::vector<ComplexOrRealType> VectorType;
+
+	//! Makes room for nvectors vectors of the given size; their contents are unspecified.
+	//! References returned by operator() before this call are invalidated
+	void resize(size_t nvectors,size_t size)
+	{
+		if (vectors_.size()<nvectors) vectors_.resize(nvectors);
+		for (size_t i=0;i<nvectors;i++) vectors_[i].resize(size);
+	}
+
+	VectorType& operator()(size_t i)
+	{
+		assert(i<vectors_.size());
+		return vectors_[i];
+	}
+
+	const VectorType& operator()(size_t i) const
+	{
+		assert(i<vectors_.size());
+		return vectors_[i];
+	}
+
+	size_t size() const { return vectors_.size(); }
+
+private:
+
+	std::vector<VectorType> vectors_;
+}; // class KrylovWorkspace
+
+} // namespace Dmrg
+
+/*@}*/
+
+#endif // KRYLOV_WORKSPACE_H
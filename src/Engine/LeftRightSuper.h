@@ -108,7 +108,8 @@ namespace Dmrg {
 			template<typename IoInputter>
 			LeftRightSuper(IoInputter& io)
 			: progress_("LeftRightSuper",0),
-			  left_(0),right_(0),super_(0),refCounter_(0)
+			  left_(0),right_(0),super_(0),refCounter_(0),
+			  leftBorrowed_(false),rightBorrowed_(false)
 			{
 				// watch out: same order as save here:
 				super_ = new SuperBlockType(io,"");
@@ -121,7 +122,8 @@ namespace Dmrg {
 					const std::string& elabel,
 					const std::string& selabel)
 			: progress_("LeftRightSuper",0),
-			  left_(0),right_(0),super_(0),refCounter_(0)
+			  left_(0),right_(0),super_(0),refCounter_(0),
+			  leftBorrowed_(false),rightBorrowed_(false)
 			{
 				left_ = new BasisWithOperatorsType(slabel);
 				right_ = new BasisWithOperatorsType(elabel);
@@ -134,8 +136,8 @@ namespace Dmrg {
 					refCounter_--;
 					return;
 				}
-				delete left_;
-				delete right_;
+				if (!leftBorrowed_) delete left_;
+				if (!rightBorrowed_) delete right_;
 				delete super_;
 			}
 
@@ -144,12 +146,14 @@ namespace Dmrg {
 					BasisWithOperatorsType& right,
 					SuperBlockType& super)
 			: progress_("LeftRightSuper",0),
-			  left_(&left),right_(&right),super_(&super),refCounter_(1)
+			  left_(&left),right_(&right),super_(&super),refCounter_(1),
+			  leftBorrowed_(false),rightBorrowed_(false)
 			{
 			}
 
 			LeftRightSuper(const ThisType& rls)
-			: progress_("LeftRightSuper",0),refCounter_(1)
+			: progress_("LeftRightSuper",0),refCounter_(1),
+			  leftBorrowed_(false),rightBorrowed_(false)
 			{
 				left_=rls.left_;
 				right_=rls.right_;
@@ -169,6 +173,7 @@ namespace Dmrg {
 					   BlockType const &X,
 					   RealType time)
 			{
+				own(left_,leftBorrowed_,false);
 				grow(*left_,model,pS,X,GROW_TO_THE_RIGHT,time);
 			}
 
@@ -178,6 +183,7 @@ namespace Dmrg {
 					    BlockType const &X,
 					    RealType time)
 			{
+				own(right_,rightBorrowed_,false);
 				grow(*right_,model,pE,X,GROW_TO_THE_LEFT,time);
 			}
 
@@ -210,13 +216,30 @@ namespace Dmrg {
 				right_->save(io);
 			}
 
+			//! the bases only, as needed to compute observables
+			template<typename IoOutputType>
+			void saveWithoutOperators(IoOutputType& io) const
+			{
+				super_->save(io);
+				left_->saveWithoutOperators(io);
+				right_->saveWithoutOperators(io);
+			}
+
 			const BasisWithOperatorsType& left()  const { return *left_; }
 
 			const BasisWithOperatorsType& right() const { return *right_; }
 
-			BasisWithOperatorsType& leftNonConst()  { return *left_; }
+			BasisWithOperatorsType& leftNonConst()
+			{
+				own(left_,leftBorrowed_,true);
+				return *left_;
+			}
 
-			BasisWithOperatorsType& rightNonConst() { return *right_; }
+			BasisWithOperatorsType& rightNonConst()
+			{
+				own(right_,rightBorrowed_,true);
+				return *right_;
+			}
 
 
 			const SuperBlockType& super() const { return *super_; }
@@ -225,6 +248,7 @@ namespace Dmrg {
 			{
 				if (refCounter_>0) throw std::runtime_error
 						("LeftRightSuper::left(...): not the owner\n");
+				own(left_,leftBorrowed_,false);
 				*left_=left; // deep copy
 			}
 
@@ -232,13 +256,38 @@ namespace Dmrg {
 			{
 				if (refCounter_>0) throw std::runtime_error
 						("LeftRightSuper::right(...): not the owner\n");
+				own(right_,rightBorrowed_,false);
 				*right_=right; // deep copy
 			}
 
+			//! left_ points to left, the top of the checkpoint stack, instead of
+			//! holding a copy of it. left must stay in place, and unchanged, until
+			//! the next growLeftBlock, which builds a block of our own again
+			void borrowLeft(BasisWithOperatorsType& left)
+			{
+				if (refCounter_>0) throw std::runtime_error
+						("LeftRightSuper::borrowLeft(...): not the owner\n");
+				if (!leftBorrowed_) delete left_;
+				left_ = &left;
+				leftBorrowed_ = true;
+			}
+
+			//! as borrowLeft for the right block
+			void borrowRight(BasisWithOperatorsType& right)
+			{
+				if (refCounter_>0) throw std::runtime_error
+						("LeftRightSuper::borrowRight(...): not the owner\n");
+				if (!rightBorrowed_) delete right_;
+				right_ = &right;
+				rightBorrowed_ = true;
+			}
+
 
 			template<typename IoInputType>
 			void load(IoInputType& io)
 			{
+				own(left_,leftBorrowed_,false);
+				own(right_,rightBorrowed_,false);
 				super_->load(io);
 				left_->load(io);
 				right_->load(io);
@@ -247,8 +296,21 @@ namespace Dmrg {
 		private:
 			LeftRightSuper(ThisType& rls);
 
+			// a borrowed block is replaced by one of our own, with copy a copy
+			// of the borrowed block, else an empty one that is about to be set
+			void own(BasisWithOperatorsType*& block,bool& borrowed,bool copy)
+			{
+				if (!borrowed) return;
+				BasisWithOperatorsType* mine = new BasisWithOperatorsType(block->name());
+				if (copy) *mine = *block; // deep copy
+				block = mine;
+				borrowed = false;
+			}
+
 			void deepCopy(const ThisType& rls)
 			{
+				own(left_,leftBorrowed_,false);
+				own(right_,rightBorrowed_,false);
 				*left_=*rls.left_;
 				*right_=*rls.right_;
 				*super_=*rls.super_;
@@ -272,7 +334,7 @@ namespace Dmrg {
 			\\cppFunction{addHamiltonianConnection}, see !PTEX\\_REF{295}. 
 			Finally, the resulting dmrgBasis object for the outer product, 
 			pSprime, is set to contain this full Hamiltonian with the call
-			to  \\cppFunction{pSprime.setHamiltonian(matrix)}. 
+			to  \\cppFunction{pSprime.hamiltonianChanged()}. 
 			*/
 			template<typename SomeModelType>
 			void grow(BasisWithOperatorsType& leftOrRight,
@@ -289,9 +351,7 @@ namespace Dmrg {
 				BasisWithOperatorsType Xbasis("Xbasis");
 
 				Xbasis.setVarious(X,hmatrix,q,creationMatrix);
-				leftOrRight.setToProduct(pS,Xbasis,dir);
-
-				SparseMatrixType matrix=leftOrRight.hamiltonian();
+				leftOrRight.setToProduct(pS,Xbasis,dir,model.concurrency(),model.params().nthreads);
 
 				ThisType* lrs;
 				BasisType* leftOrRightL =  &leftOrRight;
@@ -301,9 +361,10 @@ namespace Dmrg {
 					lrs = new  ThisType(Xbasis,pS,*leftOrRightL);
 				}
 				//!PTEX_LABEL{295}
-				model.addHamiltonianConnection(matrix,*lrs);
+				// connections are summed in place, no copy of the Hamiltonian
+				model.addHamiltonianConnection(leftOrRight.hamiltonianNonConst(),*lrs);
 				delete lrs;
-				leftOrRight.setHamiltonian(matrix);
+				leftOrRight.hamiltonianChanged();
 			}
 
 			ProgressIndicatorType progress_;
@@ -311,6 +372,7 @@ namespace Dmrg {
 			BasisWithOperatorsType* right_;
 			SuperBlockType* super_;
 			size_t refCounter_;
+			bool leftBorrowed_,rightBorrowed_;
 			
 	}; // class LeftRightSuper
 
@@ -74,28 +74,161 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 
 /*! \file LinkProductStruct.h
  *
- *  A struct to hold link product saved data to run with pthreads
+ *  A struct to hold the connection plan of one symmetry sector: the
+ *  resolved links, each with its system and environment operators,
+ *  computed once per ModelHelper and reused for every x+=Hy
  *
  */
 #ifndef LINK_PRODUCT_STRUCT_H
 #define LINK_PRODUCT_STRUCT_H
-
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include "ProgramGlobals.h"
 
 namespace Dmrg {
-	template<typename FieldType>
+	template<typename SparseMatrixType,typename LinkType>
 	struct LinkProductStruct {
-		LinkProductStruct(size_t maxSize)
-		: isaved(maxSize),jsaved(maxSize),typesaved(maxSize),
-		  tmpsaved(maxSize),dofssaved(maxSize),termsaved(maxSize) {}
-		std::vector<size_t> isaved,jsaved; //,dof1saved,dof2saved;
-		std::vector<int> typesaved;
-		std::vector<FieldType> tmpsaved;
-		std::vector<size_t> dofssaved,termsaved;
-#ifdef NOMUTEX
-		mutable std::vector<std::vector<FieldType> > xtemp;
-#endif
-	}; // 
+
+		LinkProductStruct() : compiled(false) {}
+
+		// A and B point into the ModelHelper that owns this struct,
+		// so a copy starts empty and is compiled again by its new owner
+		LinkProductStruct(const LinkProductStruct&) : compiled(false) {}
+
+		LinkProductStruct& operator=(const LinkProductStruct&)
+		{
+			clear();
+			return *this;
+		}
+
+		void clear()
+		{
+			links.clear();
+			A.clear();
+			B.clear();
+			merged_.clear();
+			compiled = false;
+		}
+
+		void push(const LinkType& link,
+		          const SparseMatrixType* a,
+		          const SparseMatrixType* b)
+		{
+			links.push_back(link);
+			A.push_back(a);
+			B.push_back(b);
+		}
+
+		size_t size() const { return links.size(); }
+
+		//! Rewrites the plan so that links with the same system operator A become
+		//! the single link A \otimes (\sum_k v_k B_k), and then links with the same
+		//! environment operator B become the single link (\sum_k v_k A_k) \otimes B,
+		//! so that each group costs one pass over the vector instead of one per link.
+		//! Afterwards all links are SYSTEM_ENVIRON, and merged links have value 1
+		//! and keep the sites and dofs of the first link of their group.
+		//! Only valid if the product of a link depends on nothing but A, B, value,
+		//! type and fermionOrBoson, so not for SU(2)
+		void merge()
+		{
+			for (size_t ix=0;ix<links.size();ix++) {
+				if (links[ix].type!=ProgramGlobals::ENVIRON_SYSTEM) continue;
+				if (links[ix].fermionOrBoson==ProgramGlobals::FERMION) links[ix].value *= -1.0;
+				links[ix].type = ProgramGlobals::SYSTEM_ENVIRON;
+				std::swap(A[ix],B[ix]);
+			}
+
+			mergeBy(A,B);
+			mergeBy(B,A);
+		}
+
+		bool compiled;
+		std::vector<LinkType> links;
+		std::vector<const SparseMatrixType*> A,B;
+
+	private:
+
+		// Links with the same same[ix] and fermionOrBoson are replaced by one link
+		// whose other operator is the sum of other[k] weighted by the values
+		void mergeBy(std::vector<const SparseMatrixType*>& same,
+		             std::vector<const SparseMatrixType*>& other)
+		{
+			std::vector<bool> done(links.size(),false);
+			std::vector<LinkType> links2;
+			std::vector<const SparseMatrixType*> same2,other2;
+
+			for (size_t ix=0;ix<links.size();ix++) {
+				if (done[ix]) continue;
+				std::vector<size_t> group(1,ix);
+				for (size_t jx=ix+1;jx<links.size();jx++) {
+					if (done[jx] || same[jx]!=same[ix]) continue;
+					if (links[jx].fermionOrBoson!=links[ix].fermionOrBoson) continue;
+					group.push_back(jx);
+					done[jx] = true;
+				}
+
+				links2.push_back(links[ix]);
+				same2.push_back(same[ix]);
+				if (group.size()==1) {
+					other2.push_back(other[ix]);
+					continue;
+				}
+
+				// deque::push_back does not move existing elements
+				merged_.push_back(SparseMatrixType());
+				weightedSum(merged_.back(),other,group);
+				links2.back().value = 1.0;
+				other2.push_back(&merged_.back());
+			}
+
+			links.swap(links2);
+			same.swap(same2);
+			other.swap(other2);
+		}
+
+		void weightedSum(SparseMatrixType& sum,
+		                 const std::vector<const SparseMatrixType*>& m,
+		                 const std::vector<size_t>& group) const
+		{
+			typedef typename SparseMatrixType::value_type ValueType;
+			size_t rows = m[group[0]]->row();
+			size_t cols = m[group[0]]->col();
+			std::vector<ValueType> row(cols,0.0);
+			std::vector<int> mark(cols,-1);
+			std::vector<size_t> nonzeros;
+
+			sum.resize(rows,cols);
+			size_t counter = 0;
+			for (size_t i=0;i<rows;i++) {
+				sum.setRow(i,counter);
+				nonzeros.clear();
+				for (size_t g=0;g<group.size();g++) {
+					const SparseMatrixType& mat = *m[group[g]];
+					const ValueType& value = links[group[g]].value;
+					for (int k=mat.getRowPtr(i);k<mat.getRowPtr(i+1);k++) {
+						size_t col = mat.getCol(k);
+						if (mark[col]!=int(i)) {
+							mark[col] = i;
+							row[col] = 0.0;
+							nonzeros.push_back(col);
+						}
+						row[col] += value*mat.getValue(k);
+					}
+				}
+
+				std::sort(nonzeros.begin(),nonzeros.end());
+				for (size_t k=0;k<nonzeros.size();k++) {
+					sum.pushCol(nonzeros[k]);
+					sum.pushValue(row[nonzeros[k]]);
+					counter++;
+				}
+			}
+			sum.setRow(rows,counter);
+		}
+
+		std::deque<SparseMatrixType> merged_;
+	}; // struct LinkProductStruct
 } // namespace Dmrg
 /*@}*/
 #endif
-
@@ -90,6 +90,7 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "InputNg.h"
 #include "InputCheck.h"
 #include "ProgressIndicator.h"
+#include "CrsMatrixArena.h"
 
 namespace Dmrg {
 	
@@ -117,6 +118,7 @@ namespace Dmrg {
 
 		typedef typename SparseMatrixType::value_type SparseElementType;
 		typedef VerySparseMatrix<SparseElementType> VerySparseMatrixType;
+		typedef ArenaMatrix<SparseMatrixType> ArenaMatrixType;
 
 	public:
 
@@ -153,22 +155,30 @@ namespace Dmrg {
 		 */
 		void matrixVectorProduct(std::vector<RealType> &x,std::vector<RealType> const &y,ModelHelperType const &modelHelper) const
 		{
-			//! contribution to Hamiltonian from current system
-			modelHelper.hamiltonianLeftProduct(x,y);
-			//! contribution to Hamiltonian from current envirnoment
-			modelHelper.hamiltonianRightProduct(x,y);
-			//! contribution to Hamiltonian from connection system-environment
-			hamiltonianConnectionProduct(x,y,modelHelper);
+			//! contributions to Hamiltonian from current system, current environment
+			//! and connection system-environment, threaded over rows of x
+			hamiltonianProduct(x,y,modelHelper);
 		}
 
 		void matrixVectorProduct(std::vector<std::complex<RealType> > &x,std::vector<std::complex<RealType> > const &y,ModelHelperType const &modelHelper) const
 		{
-			//! contribution to Hamiltonian from current system
-			modelHelper.hamiltonianLeftProduct(x,y);
-			//! contribution to Hamiltonian from current envirnoment
-			modelHelper.hamiltonianRightProduct(x,y);
-			//! contribution to Hamiltonian from connection system-environment
-			hamiltonianConnectionProduct(x,y,modelHelper);
+			//! contributions to Hamiltonian from current system, current environment
+			//! and connection system-environment, threaded over rows of x
+			hamiltonianProduct(x,y,modelHelper);
+		}
+
+		/** Same as matrixVectorProduct but for nvectors vectors at once, stored
+		 * interleaved in x and y: entry i of vector v is x[i*nvectors+v].
+		 * Each Hamiltonian term is loaded once for all the vectors
+		 */
+		void matrixMatrixProduct(std::vector<RealType> &x,std::vector<RealType> const &y,size_t nvectors,ModelHelperType const &modelHelper) const
+		{
+			hamiltonianProduct(x,y,nvectors,modelHelper);
+		}
+
+		void matrixMatrixProduct(std::vector<std::complex<RealType> > &x,std::vector<std::complex<RealType> > const &y,size_t nvectors,ModelHelperType const &modelHelper) const
+		{
+			hamiltonianProduct(x,y,nvectors,modelHelper);
 		}
 
 		/**
@@ -183,7 +193,10 @@ namespace Dmrg {
 		void addHamiltonianConnection(SparseMatrixType &matrix,const LeftRightSuperType& lrs) const
 		{
 			int bs,offset;
-			SparseMatrixType matrixBlock;
+			ArenaMatrixType arenaBlock;
+			ArenaMatrixType arenaBlock2;
+			SparseMatrixType& matrixBlock = arenaBlock();
+			SparseMatrixType& matrixBlock2 = arenaBlock2();
 
 			for (size_t m=0;m<lrs.super().partition()-1;m++) {
 				offset =lrs.super().partition(m);
@@ -193,7 +206,6 @@ namespace Dmrg {
 
 				VerySparseMatrixType vsm(matrixBlock.row());
 				addHamiltonianConnection(vsm,modelHelper);
-				SparseMatrixType matrixBlock2;
 				matrixBlock2 = vsm;
 				matrixBlock += matrixBlock2;
 
@@ -213,14 +225,28 @@ namespace Dmrg {
 		void hamiltonianConnectionProduct(std::vector<SparseElementType> &x,std::vector<SparseElementType> const &y,
 			ModelHelperType const &modelHelper) const
 		{
-			size_t n=modelHelper.leftRightSuper().super().block().size();
+			const LinkProductStructType& lps = linkProductStruct(modelHelper);
+			HamiltonianConnectionType hc(dmrgGeometry_,modelHelper,&lps,&x,&y);
 
-			//SparseMatrixType matrix;
-			size_t maxSize = maxConnections() * 4 * 16;
-			maxSize *= maxSize;
+			ParallelConnectionsType parallelConnections;
+			parallelConnections.loopCreate(x.size(),hc,concurrency_);
+			hc.sync(parallelConnections,concurrency_);
+		}
 
-			static LinkProductStructType lps(maxSize);
-			HamiltonianConnectionType hc(dmrgGeometry_,modelHelper,&lps,&x,&y);
+		/**
+		Returns the connection plan for the sector of modelHelper: the links
+		between system and environment, resolved to their operators.
+		It depends only on the LeftRightSuper and the partition, so it is
+		computed the first time it is needed and kept in the modelHelper.
+		Without SU(2), links sharing an operator are merged, see LinkProductStruct::merge
+		*/
+		const LinkProductStructType& linkProductStruct(ModelHelperType const &modelHelper) const
+		{
+			LinkProductStructType& lps = modelHelper.linkProductStruct();
+			if (lps.compiled) return lps;
+
+			size_t n=modelHelper.leftRightSuper().super().block().size();
+			HamiltonianConnectionType hc(dmrgGeometry_,modelHelper);
 
 			size_t total = 0;
 			for (size_t i=0;i<n;i++) {
@@ -228,10 +254,9 @@ namespace Dmrg {
 					hc.compute(i,j,0,&lps,total);
 				}
 			}
-
-			ParallelConnectionsType parallelConnections;
-			parallelConnections.loopCreate(total,hc,concurrency_);
-			hc.sync(parallelConnections,concurrency_);
+			if (!ModelHelperType::isSu2()) lps.merge();
+			lps.compiled = true;
+			return lps;
 		}
 
 		/**
@@ -261,6 +286,31 @@ namespace Dmrg {
 
 	private:
 
+		//! Does x += H_m y with the number of threads given by the nthreads parameter;
+		//! each thread owns a contiguous slice of x
+		void hamiltonianProduct(std::vector<SparseElementType> &x,std::vector<SparseElementType> const &y,
+			ModelHelperType const &modelHelper) const
+		{
+			const LinkProductStructType& lps = linkProductStruct(modelHelper);
+			HamiltonianConnectionType hc(dmrgGeometry_,modelHelper,&lps,&x,&y,true);
+
+			ParallelConnectionsType parallelConnections;
+			parallelConnections.loopCreate(x.size(),hc,concurrency_);
+			hc.sync(parallelConnections,concurrency_);
+		}
+
+		//! Same as above for nvectors interleaved vectors; each thread owns a slice of rows
+		void hamiltonianProduct(std::vector<SparseElementType> &x,std::vector<SparseElementType> const &y,
+			size_t nvectors,ModelHelperType const &modelHelper) const
+		{
+			const LinkProductStructType& lps = linkProductStruct(modelHelper);
+			HamiltonianConnectionType hc(dmrgGeometry_,modelHelper,&lps,&x,&y,true,nvectors);
+
+			ParallelConnectionsType parallelConnections;
+			parallelConnections.loopCreate(x.size()/nvectors,hc,concurrency_);
+			hc.sync(parallelConnections,concurrency_);
+		}
+
 		//! Add Hamiltonian connection between basis2 and basis3 in the orderof basis1 for symmetry block m
 		void addHamiltonianConnection(VerySparseMatrix<SparseElementType>& matrix,
 					      const ModelHelperType& modelHelper) const
@@ -275,9 +325,11 @@ namespace Dmrg {
 			SomeHamiltonianConnectionType hc(dmrgGeometry_,modelHelper);
 
 			size_t total = 0;
+			ArenaMatrixType arenaBlock;
+			SparseMatrixType& matrixBlock = arenaBlock();
 			for (size_t i=0;i<n;i++) {
 				for (size_t j=0;j<n;j++) {
-					SparseMatrixType matrixBlock(matrixRank,matrixRank);
+					matrixBlock.resize(matrixRank,matrixRank);
 					if (!hc.compute(i,j,&matrixBlock,0,total)) continue;
 					VerySparseMatrixType vsm(matrixBlock);
 					matrix2+=vsm;
@@ -171,6 +171,11 @@ namespace Dmrg {
 		  modelFeAsExt_(0),
 		  modelImmm_(0)
 		{
+			bool blocked = (params.options.find("useBlockedKernel")!=std::string::npos);
+			ModelHelperType::useBlockedKernel(blocked);
+			bool lazy = (params.options.find("lazyOperators")!=std::string::npos);
+			OperatorsType::lazyOperators(lazy);
+
 			std::string name = params.model;
 			if (name=="HubbardOneBand") {
 				modelHubbard_ = new ModelHubbardType(io,geometry,concurrency);
@@ -342,6 +347,28 @@ namespace Dmrg {
 			}
 		}
 
+		template<typename SomeVectorType>
+		void matrixMatrixProduct(SomeVectorType& x,
+					 const SomeVectorType& y,
+					 size_t nvectors,
+					 ModelHelperType const &modelHelper) const
+		{
+			switch(model_) {
+			case HUBBARD_ONE_BAND:
+				return modelHubbard_->matrixMatrixProduct(x,y,nvectors,modelHelper);
+			case HEISENBERG_SPIN_ONEHALF:
+				return modelHeisenberg_->matrixMatrixProduct(x,y,nvectors,modelHelper);
+			case HUBBARD_ONE_BAND_EXT:
+				return modelHubbardExt_->matrixMatrixProduct(x,y,nvectors,modelHelper);
+			case FEAS:
+				return modelFeAs_->matrixMatrixProduct(x,y,nvectors,modelHelper);
+			case FEAS_EXT:
+				return modelFeAsExt_->matrixMatrixProduct(x,y,nvectors,modelHelper);
+			case IMMM:
+				return modelImmm_->matrixMatrixProduct(x,y,nvectors,modelHelper);
+			}
+		}
+
 		void addHamiltonianConnection(SparseMatrixType &matrix,const LeftRightSuperType& lrs) const
 		{
 			switch(model_) {
@@ -430,46 +457,23 @@ namespace Dmrg {
 //			return params_.model;
 //		}
 
-		size_t getLinkProductStruct(LinkProductStructType** lps,const ModelHelperType& modelHelper) const
+		const LinkProductStructType& linkProductStruct(const ModelHelperType& modelHelper) const
 		{
 			switch(model_) {
 			case HUBBARD_ONE_BAND:
-				return getLinkProductStruct2<ModelHubbardType>(lps,modelHelper);
+				return modelHubbard_->linkProductStruct(modelHelper);
 			case HEISENBERG_SPIN_ONEHALF:
-				return getLinkProductStruct2<ModelHeisenbergType>(lps,modelHelper);
+				return modelHeisenberg_->linkProductStruct(modelHelper);
 			case HUBBARD_ONE_BAND_EXT:
-				return getLinkProductStruct2<ModelHubbardExtType>(lps,modelHelper);
+				return modelHubbardExt_->linkProductStruct(modelHelper);
 			case FEAS:
-				return getLinkProductStruct2<FeBasedScType>(lps,modelHelper);
+				return modelFeAs_->linkProductStruct(modelHelper);
 			case FEAS_EXT:
-				return getLinkProductStruct2<FeBasedScExtType>(lps,modelHelper);
+				return modelFeAsExt_->linkProductStruct(modelHelper);
 			case IMMM:
-				return getLinkProductStruct2<ModelHubbardType>(lps,modelHelper);
+				return modelImmm_->linkProductStruct(modelHelper);
 			}
-			return 0;
-		}
-
-		LinkType getConnection(const SparseMatrixType** A,
-				   const SparseMatrixType** B,
-				   size_t ix,
-				   const LinkProductStructType& lps,
-				   const ModelHelperType& modelHelper) const
-		{
-			switch(model_) {
-			case HUBBARD_ONE_BAND:
-				return getConnection2<ModelHubbardType>(A,B,ix,lps,modelHelper);
-			case HEISENBERG_SPIN_ONEHALF:
-				return getConnection2<ModelHeisenbergType>(A,B,ix,lps,modelHelper);
-			case HUBBARD_ONE_BAND_EXT:
-				return getConnection2<ModelHubbardExtType>(A,B,ix,lps,modelHelper);
-			case FEAS:
-				return getConnection2<FeBasedScType>(A,B,ix,lps,modelHelper);
-			case FEAS_EXT:
-				return getConnection2<FeBasedScExtType>(A,B,ix,lps,modelHelper);
-			case IMMM:
-				return getConnection2<ModelHubbardType>(A,B,ix,lps,modelHelper);
-			}
-			throw std::runtime_error("getConnection(...) failed\n");
+			throw std::runtime_error("linkProductStruct(...) failed\n");
 		}
 
 		void findElectronsOfOneSite(std::vector<size_t>& electrons,size_t site) const
@@ -484,46 +488,6 @@ namespace Dmrg {
 
 	private:
 
-		template<typename SomeModelType>
-		LinkType getConnection2(const SparseMatrixType** A,
-				    const SparseMatrixType** B,
-				    size_t ix,
-				    const LinkProductStructType& lps,
-				    const ModelHelperType& modelHelper) const
-		{
-			typedef typename SomeModelType::HamiltonianConnectionType HamiltonianConnectionType;
-			std::vector<ComplexOrRealType> x,y; // bogus
-			HamiltonianConnectionType hc(geometry_,modelHelper,&lps,&x,&y);
-			size_t i =0, j = 0, type = 0,term = 0, dofs =0;
-			ComplexOrRealType tmp = 0.0;
-			hc.prepare(ix,i,j,type,tmp,term,dofs);
-			LinkType link2 = hc.getKron(A,B,i,j,type,tmp,term,dofs);
-			return link2;
-		}
-
-		template<typename SomeModelType>
-		size_t getLinkProductStruct2(LinkProductStructType** lps,const ModelHelperType& modelHelper) const
-		{
-			size_t n=modelHelper.leftRightSuper().super().block().size();
-			size_t maxSize = geometry_.maxConnections() * 4 * 16;
-			maxSize *= maxSize;
-
-			*lps = new LinkProductStructType(maxSize);
-
-			std::vector<ComplexOrRealType> x,y; // bogus
-
-			typedef typename SomeModelType::HamiltonianConnectionType HamiltonianConnectionType;
-			HamiltonianConnectionType hc(geometry_,modelHelper,*lps,&x,&y);
-			size_t total = 0;
-			for (size_t i=0;i<n;i++) {
-				for (size_t j=0;j<n;j++) {
-					hc.compute(i,j,0,*lps,total);
-				}
-			}
-			return total;
-		}
-
-
 		template<typename SomeModelType>
 		void init(SomeModelType* model)
 		{
@@ -74,6 +74,9 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 
 #include "PackIndices.h" // in PsimagLite
 #include "Link.h"
+#include "LinkProductStruct.h"
+#include "SectorIndexMap.h"
+#include "CrsMatrixArena.h"
 
 /** \ingroup DMRG */
 /*@{*/
@@ -103,6 +106,8 @@ namespace Dmrg {
 		typedef typename BasisType::RealType RealType;
 		typedef typename LeftRightSuperType::BasisWithOperatorsType BasisWithOperatorsType;
 		typedef Link<SparseElementType,RealType> LinkType;
+		typedef LinkProductStruct<SparseMatrixType,LinkType> LinkProductStructType;
+		typedef CrsMatrixArena<SparseMatrixType> ArenaType;
 
 		enum { System=0,Environ=1 };
 
@@ -111,14 +116,35 @@ namespace Dmrg {
 		                 bool useReflection=false)
 		: m_(m),
 		  lrs_(lrs),
-		  buffer_(lrs_.left().size()),
-		  basis2tc_(lrs_.left().numberOfOperators()),
-		  basis3tc_(lrs_.right().numberOfOperators())
+		  basis2tc_(lrs_.left().numberOfOperators(),0),
+		  basis3tc_(lrs_.right().numberOfOperators(),0)
 		{
-			createBuffer();
+			createAlphaAndBeta();
+			buffer_ = SectorIndexMap(alpha_,beta_,lrs_.left().size());
+			// with lazy operators only those needed are made, by getTcOperator
+			if (OperatorsType::lazyOperators()) return;
 			createTcOperators(basis2tc_,lrs_.left());
 			createTcOperators(basis3tc_,lrs_.right());
-			createAlphaAndBeta();
+		}
+
+		ModelHelperLocal(const ModelHelperLocal& other)
+		: m_(other.m_),
+		  lrs_(other.lrs_),
+		  buffer_(other.buffer_),
+		  basis2tc_(other.basis2tc_.size(),0),
+		  basis3tc_(other.basis3tc_.size(),0),
+		  alpha_(other.alpha_),
+		  beta_(other.beta_),
+		  lps_(other.lps_)
+		{
+			copyTcOperators(basis2tc_,other.basis2tc_);
+			copyTcOperators(basis3tc_,other.basis3tc_);
+		}
+
+		~ModelHelperLocal()
+		{
+			releaseTcOperators(basis2tc_);
+			releaseTcOperators(basis3tc_);
 		}
 
 		size_t m() const { return m_; }
@@ -130,15 +156,16 @@ namespace Dmrg {
 		                                          size_t sigma,
 		                                          size_t type) const
 		{
-			if (modifier=='N') {
-				if (type==System) {
-					PairType ii =lrs_.left().getOperatorIndices(i,sigma); 
-					return lrs_.left().getOperatorByIndex(ii.first).data;
-				} else {
-					PairType ii =lrs_.right().getOperatorIndices(i,sigma);
-					return lrs_.right().getOperatorByIndex(ii.first).data;
-				}
+			const BasisWithOperatorsType& basis = (type==System) ? lrs_.left() : lrs_.right();
+			PairType ii = basis.getOperatorIndices(i,sigma);
+			const SparseMatrixType& op = basis.getOperatorByIndex(ii.first).data;
+			if (op.row()==0) {
+				std::string s(__FILE__);
+				s += ": operator was dropped, is the geometry's maxConnections";
+				s += " too small for onlyNeededOperators?\n";
+				throw std::runtime_error(s.c_str());
 			}
+			if (modifier=='N') return op;
 			return getTcOperator(i,sigma,type);
 		}
 
@@ -190,7 +217,7 @@ namespace Dmrg {
 					int alphaPrime = A.getCol(k);
 					for (int kk=B.getRowPtr(beta);kk<B.getRowPtr(beta+1);kk++) {
 						int betaPrime= B.getCol(kk);
-						int j = buffer_[alphaPrime][betaPrime];
+						int j = buffer_(alphaPrime,betaPrime);
 						if (j<0) continue;
 						/* fermion signs note:
 						   here the environ is applied first and has to "cross"
@@ -217,6 +244,20 @@ namespace Dmrg {
 		                     SparseMatrixType const &B,
 		                     const LinkType& link,
 		                     bool flipped = false) const
+		{
+			fastOpProdInter(x,y,A,B,link,0,size(),flipped);
+		}
+
+		//! Same as above but updates only rows [rowStart,rowEnd) of x, so that
+		//! threads owning disjoint row ranges do not need to synchronize
+		void fastOpProdInter(std::vector<SparseElementType>  &x,
+		                     std::vector<SparseElementType>  const &y,
+		                     SparseMatrixType const &A,
+		                     SparseMatrixType const &B,
+		                     const LinkType& link,
+		                     size_t rowStart,
+		                     size_t rowEnd,
+		                     bool flipped = false) const
 		{
 			RealType fermionSign =  (link.fermionOrBoson==ProgramGlobals::FERMION) ? -1 : 1;
 
@@ -224,16 +265,17 @@ namespace Dmrg {
 				LinkType link2 = link;
 				link2.value *= fermionSign;
 				link2.type = ProgramGlobals::SYSTEM_ENVIRON;
-				fastOpProdInter(x,y,B,A,link2,true);
+				fastOpProdInter(x,y,B,A,link2,rowStart,rowEnd,true);
 				return;
 			}
 
-			//! work only on partition m
-			int m = m_;
-			int offset = lrs_.super().partition(m);
-			int total = lrs_.super().partition(m+1) - offset;
+			if (useBlockedKernel_) {
+				fastOpProdInterBlocked(x,y,A,B,link,rowStart,rowEnd);
+				return;
+			}
 
-			for (int i=0;i<total;i++) {
+			//! work only on rows [rowStart,rowEnd) of partition m
+			for (size_t i=rowStart;i<rowEnd;i++) {
 				// row i of the ordered product basis
 				int alpha=alpha_[i];
 				int beta=beta_[i];
@@ -251,11 +293,10 @@ namespace Dmrg {
 				for (int k=startk;k<endk;k++) {
 					int alphaPrime = A.getCol(k);
 					SparseElementType tmp2 = A.getValue(k) *fsValue;
-					const std::vector<int>& bufferTmp = buffer_[alphaPrime];
 
 					for (int kk=startkk;kk<endkk;kk++) {
 						int betaPrime= B.getCol(kk);
-						int j = bufferTmp[betaPrime];
+						int j = buffer_(alphaPrime,betaPrime);
 						if (j<0) continue;
 
 						SparseElementType tmp = tmp2 * B.getValue(kk);
@@ -265,6 +306,55 @@ namespace Dmrg {
 			}
 		}
 
+		//! Same as fastOpProdInter(x,y,A,B,link,rowStart,rowEnd) but for nvectors vectors
+		//! at once, stored interleaved: entry i of vector v is x[i*nvectors+v]
+		void fastOpProdInterVectors(std::vector<SparseElementType>  &x,
+		                            std::vector<SparseElementType>  const &y,
+		                            SparseMatrixType const &A,
+		                            SparseMatrixType const &B,
+		                            const LinkType& link,
+		                            size_t rowStart,
+		                            size_t rowEnd,
+		                            size_t nvectors) const
+		{
+			RealType fermionSign =  (link.fermionOrBoson==ProgramGlobals::FERMION) ? -1 : 1;
+
+			if (link.type==ProgramGlobals::ENVIRON_SYSTEM)  {
+				LinkType link2 = link;
+				link2.value *= fermionSign;
+				link2.type = ProgramGlobals::SYSTEM_ENVIRON;
+				fastOpProdInterVectors(x,y,B,A,link2,rowStart,rowEnd,nvectors);
+				return;
+			}
+
+			for (size_t i=rowStart;i<rowEnd;i++) {
+				int alpha=alpha_[i];
+				int beta=beta_[i];
+				SparseElementType* xSubI = &(x[i*nvectors]);
+				int startkk = B.getRowPtr(beta);
+				int endkk = B.getRowPtr(beta+1);
+				/* fermion signs note: see fastOpProdInter */
+				SparseElementType fsValue = (link.fermionOrBoson == ProgramGlobals::FERMION) ? lrs_.left().fermionicSign(alpha,int(fermionSign))*link.value : link.value;
+
+				for (int k=A.getRowPtr(alpha);k<A.getRowPtr(alpha+1);k++) {
+					int alphaPrime = A.getCol(k);
+					SparseElementType tmp2 = A.getValue(k) *fsValue;
+
+					for (int kk=startkk;kk<endkk;kk++) {
+						int j = buffer_(alphaPrime,B.getCol(kk));
+						if (j<0) continue;
+
+						SparseElementType tmp = tmp2 * B.getValue(kk);
+						const SparseElementType* ySubJ = &(y[j*nvectors]);
+						for (size_t v=0;v<nvectors;v++) xSubI[v] += tmp * ySubJ[v];
+					}
+				}
+			}
+		}
+
+		//! Selects the kernel used by fastOpProdInter(x,y,...), see fastOpProdInterBlocked
+		static void useBlockedKernel(bool flag) { useBlockedKernel_ = flag; }
+
 		//! Let H_{alpha,beta; alpha',beta'} = basis2.hamiltonian_{alpha,alpha'} \delta_{beta,beta'}
 		//! Let H_m be  the m-th block (in the ordering of basis1) of H
 		//! Then, this function does x += H_m * y
@@ -273,24 +363,50 @@ namespace Dmrg {
 		void hamiltonianLeftProduct(std::vector<SparseElementType> &x,
 		                            std::vector<SparseElementType> const &y) const
 		{
-			int m = m_;
-			int offset = lrs_.super().partition(m);
-			int i,k,alphaPrime;
-			int bs = lrs_.super().partition(m+1)-offset;
-			SparseMatrixType hamiltonian = lrs_.left().hamiltonian();
-			size_t ns = lrs_.left().size();
+			hamiltonianLeftProduct(x,y,0,size());
+		}
 
-			PackIndicesType pack(ns);
-			for (i=0;i<bs;i++) {
-				size_t r,beta;
-				pack.unpack(r,beta,lrs_.super().permutation(i+offset));
+		//! Same as above but only for rows [rowStart,rowEnd) of x
+		void hamiltonianLeftProduct(std::vector<SparseElementType> &x,
+		                            std::vector<SparseElementType> const &y,
+		                            size_t rowStart,
+		                            size_t rowEnd) const
+		{
+			const SparseMatrixType& hamiltonian = lrs_.left().hamiltonian();
 
+			for (size_t i=rowStart;i<rowEnd;i++) {
+				size_t r = alpha_[i];
+				size_t beta = beta_[i];
+				SparseElementType sum = 0.0;
 				// row i of the ordered product basis
-				for (k=hamiltonian.getRowPtr(r);k<hamiltonian.getRowPtr(r+1);k++) {
-					alphaPrime = hamiltonian.getCol(k);
-					int j = buffer_[alphaPrime][beta];
+				for (int k=hamiltonian.getRowPtr(r);k<hamiltonian.getRowPtr(r+1);k++) {
+					int j = buffer_(hamiltonian.getCol(k),beta);
 					if (j<0) continue;
-					x[i]+= hamiltonian.getValue(k)*y[j];
+					sum += hamiltonian.getValue(k)*y[j];
+				}
+				x[i] += sum;
+			}
+		}
+
+		//! Same as above but for nvectors vectors stored interleaved, see fastOpProdInterVectors
+		void hamiltonianLeftProductVectors(std::vector<SparseElementType> &x,
+		                                   std::vector<SparseElementType> const &y,
+		                                   size_t rowStart,
+		                                   size_t rowEnd,
+		                                   size_t nvectors) const
+		{
+			const SparseMatrixType& hamiltonian = lrs_.left().hamiltonian();
+
+			for (size_t i=rowStart;i<rowEnd;i++) {
+				size_t r = alpha_[i];
+				size_t beta = beta_[i];
+				SparseElementType* xSubI = &(x[i*nvectors]);
+				for (int k=hamiltonian.getRowPtr(r);k<hamiltonian.getRowPtr(r+1);k++) {
+					int j = buffer_(hamiltonian.getCol(k),beta);
+					if (j<0) continue;
+					SparseElementType tmp = hamiltonian.getValue(k);
+					const SparseElementType* ySubJ = &(y[j*nvectors]);
+					for (size_t v=0;v<nvectors;v++) xSubI[v] += tmp * ySubJ[v];
 				}
 			}
 		}
@@ -302,23 +418,50 @@ namespace Dmrg {
 		void hamiltonianRightProduct(std::vector<SparseElementType> &x,
 		                             std::vector<SparseElementType> const &y) const
 		{
-			int m = m_;
-			int offset = lrs_.super().partition(m);
-			int i,k;
-			int bs = lrs_.super().partition(m+1)-offset;
-			SparseMatrixType hamiltonian = lrs_.right().hamiltonian();
-			size_t ns = lrs_.left().size();
+			hamiltonianRightProduct(x,y,0,size());
+		}
 
-			PackIndicesType pack(ns);
-			for (i=0;i<bs;i++) {
-				size_t alpha,r;
-				pack.unpack(alpha,r,lrs_.super().permutation(i+offset));
+		//! Same as above but only for rows [rowStart,rowEnd) of x
+		void hamiltonianRightProduct(std::vector<SparseElementType> &x,
+		                             std::vector<SparseElementType> const &y,
+		                             size_t rowStart,
+		                             size_t rowEnd) const
+		{
+			const SparseMatrixType& hamiltonian = lrs_.right().hamiltonian();
 
+			for (size_t i=rowStart;i<rowEnd;i++) {
+				size_t alpha = alpha_[i];
+				size_t r = beta_[i];
+				SparseElementType sum = 0.0;
 				// row i of the ordered product basis
-				for (k=hamiltonian.getRowPtr(r);k<hamiltonian.getRowPtr(r+1);k++) {
-					int j = buffer_[alpha][hamiltonian.getCol(k)];
+				for (int k=hamiltonian.getRowPtr(r);k<hamiltonian.getRowPtr(r+1);k++) {
+					int j = buffer_(alpha,hamiltonian.getCol(k));
+					if (j<0) continue;
+					sum += hamiltonian.getValue(k)*y[j];
+				}
+				x[i] += sum;
+			}
+		}
+
+		//! Same as above but for nvectors vectors stored interleaved, see fastOpProdInterVectors
+		void hamiltonianRightProductVectors(std::vector<SparseElementType> &x,
+		                                    std::vector<SparseElementType> const &y,
+		                                    size_t rowStart,
+		                                    size_t rowEnd,
+		                                    size_t nvectors) const
+		{
+			const SparseMatrixType& hamiltonian = lrs_.right().hamiltonian();
+
+			for (size_t i=rowStart;i<rowEnd;i++) {
+				size_t alpha = alpha_[i];
+				size_t r = beta_[i];
+				SparseElementType* xSubI = &(x[i*nvectors]);
+				for (int k=hamiltonian.getRowPtr(r);k<hamiltonian.getRowPtr(r+1);k++) {
+					int j = buffer_(alpha,hamiltonian.getCol(k));
 					if (j<0) continue;
-					x[i]+= hamiltonian.getValue(k)*y[j];
+					SparseElementType tmp = hamiltonian.getValue(k);
+					const SparseElementType* ySubJ = &(y[j*nvectors]);
+					for (size_t v=0;v<nvectors;v++) xSubI[v] += tmp * ySubJ[v];
 				}
 			}
 		}
@@ -335,12 +478,8 @@ namespace Dmrg {
 			int k,alphaPrime=0,betaPrime=0;
 			int bs = lrs_.super().partition(m+1)-offset;
 			size_t ns=lrs_.left().size();
-			SparseMatrixType hamiltonian;
-			if (option) {
-				hamiltonian = lrs_.left().hamiltonian();
-			} else {
-				hamiltonian = lrs_.right().hamiltonian();
-			}
+			const SparseMatrixType& hamiltonian = (option) ? lrs_.left().hamiltonian()
+			                                               : lrs_.right().hamiltonian();
 			PsimagLite::Matrix<SparseElementType> fullm;
 			crsMatrixToFullMatrix(fullm,hamiltonian);
 			matrixBlock.resize(bs,bs);
@@ -381,76 +520,149 @@ namespace Dmrg {
 			return lrs_;
 		}
 
+		//! The connection plan of partition m, filled by the model on first use
+		LinkProductStructType& linkProductStruct() const
+		{
+			return lps_;
+		}
+
 	private:
+
+		enum {TILE_SIZE = 256};
+
+		//! Same product as fastOpProdInter for a SYSTEM_ENVIRON link, reorganized as
+		//! (A \otimes B) acting on y seen as a matrix of (alpha,beta):
+		//! the rows of the sector are ordered with beta slowest, so they are
+		//! cut in tiles of at most TILE_SIZE consecutive rows sharing beta.
+		//! For each tile the row beta of B is the outer loop, so that for each
+		//! betaPrime all reads of y fall into the slice of y with that betaPrime,
+		//! and the inner loop over a row of A accumulates into a scalar
+		void fastOpProdInterBlocked(std::vector<SparseElementType>  &x,
+		                            std::vector<SparseElementType>  const &y,
+		                            SparseMatrixType const &A,
+		                            SparseMatrixType const &B,
+		                            const LinkType& link,
+		                            size_t rowStart,
+		                            size_t rowEnd) const
+		{
+			bool isFermion = (link.fermionOrBoson == ProgramGlobals::FERMION);
+			SparseElementType fsValue[TILE_SIZE];
+
+			size_t i = rowStart;
+			while (i<rowEnd) {
+				size_t beta = beta_[i];
+				size_t tileEnd = i + 1;
+				while (tileEnd<rowEnd && tileEnd-i<TILE_SIZE && beta_[tileEnd]==beta)
+					tileEnd++;
+
+				/* fermion signs note: see fastOpProdInter */
+				for (size_t r=i;r<tileEnd;r++)
+					fsValue[r-i] = (isFermion) ? lrs_.left().fermionicSign(alpha_[r],-1)*link.value
+					                           : link.value;
+
+				for (int kk=B.getRowPtr(beta);kk<B.getRowPtr(beta+1);kk++) {
+					size_t betaPrime = B.getCol(kk);
+					SparseElementType valueB = B.getValue(kk);
+
+					for (size_t r=i;r<tileEnd;r++) {
+						size_t alpha = alpha_[r];
+						SparseElementType sum = 0.0;
+						for (int k=A.getRowPtr(alpha);k<A.getRowPtr(alpha+1);k++) {
+							int j = buffer_(A.getCol(k),betaPrime);
+							if (j<0) continue;
+							sum += A.getValue(k) * y[j];
+						}
+						x[r] += sum * valueB * fsValue[r-i];
+					}
+				}
+				i = tileEnd;
+			}
+		}
+
 		int m_;
 		const LeftRightSuperType&  lrs_;
-		std::vector<std::vector<int> > buffer_;
-		std::vector<SparseMatrixType> basis2tc_,basis3tc_;
+		SectorIndexMap buffer_;
+		// transpose conjugates, borrowed from the CrsMatrixArena; 0 if not made
+		mutable std::vector<SparseMatrixType*> basis2tc_,basis3tc_;
 		std::vector<size_t> alpha_,beta_;
+		mutable LinkProductStructType lps_;
 
 		const SparseMatrixType& getTcOperator(int i,size_t sigma,size_t type) const
 		{
-			if (type==System) {
-				PairType ii =lrs_.left().getOperatorIndices(i,sigma);
-				assert(ii.first<basis2tc_.size());
-				return basis2tc_[ii.first];
+			const BasisWithOperatorsType& basis = (type==System) ? lrs_.left() : lrs_.right();
+			std::vector<SparseMatrixType*>& basistc = (type==System) ? basis2tc_ : basis3tc_;
+			PairType ii = basis.getOperatorIndices(i,sigma);
+			assert(ii.first<basistc.size());
+			if (!basistc[ii.first]) {
+				basistc[ii.first] = ArenaType::acquire();
+				transposeConjugate(*basistc[ii.first],basis.getOperatorByIndex(ii.first).data);
 			}
-			PairType ii =lrs_.right().getOperatorIndices(i,sigma);
-			assert(ii.first<basis3tc_.size());
-			return basis3tc_[ii.first];
+			return *basistc[ii.first];
 		}
 
-		void createBuffer()
+		void copyTcOperators(std::vector<SparseMatrixType*>& basistc,
+		                     const std::vector<SparseMatrixType*>& otherTc)
 		{
-			size_t ns=lrs_.left().size();
-			size_t ne=lrs_.right().size();
-			int offset = lrs_.super().partition(m_);
-			int total = lrs_.super().partition(m_+1) - offset;
+			for (size_t i=0;i<basistc.size();i++) {
+				if (!otherTc[i]) continue;
+				basistc[i] = ArenaType::acquire();
+				*basistc[i] = *otherTc[i];
+			}
+		}
 
-			std::vector<int>  tmpBuffer(ne);
-			for (size_t alphaPrime=0;alphaPrime<ns;alphaPrime++) {
-				for (size_t betaPrime=0;betaPrime<ne;betaPrime++) {
-					tmpBuffer[betaPrime] =lrs_.super().permutationInverse(alphaPrime + betaPrime*ns) -offset;
-					if (tmpBuffer[betaPrime]>=total) tmpBuffer[betaPrime]= -1;
-				}
-				buffer_[alphaPrime]=tmpBuffer;
+		void releaseTcOperators(std::vector<SparseMatrixType*>& basistc)
+		{
+			for (size_t i=0;i<basistc.size();i++) {
+				if (!basistc[i]) continue;
+				ArenaType::release(basistc[i]);
+				basistc[i] = 0;
 			}
 		}
 
-		void createTcOperators(std::vector<SparseMatrixType>& basistc,
+		void createTcOperators(std::vector<SparseMatrixType*>& basistc,
 							   const BasisWithOperatorsType& basis)
 		{
 			if (basistc.size()==0) return;
-			size_t n=basis.getOperatorByIndex(0).data.row();
+			// operators dropped by onlyNeededOperators are empty and skipped
+			size_t n = 0;
 			bool b = true;
 			for (size_t i=0;i<basistc.size();i++) {
-				if (basis.getOperatorByIndex(i).data.row()!=n) {
+				size_t rows = basis.getOperatorByIndex(i).data.row();
+				if (rows==0) continue;
+				if (n==0) n = rows;
+				if (rows!=n) {
 					b=false;
 					break;
 				}
 			}
-			if (b) createTcOperatorsCached(basistc,basis);
+			if (n==0) return;
+			if (b) createTcOperatorsCached(basistc,basis,n);
 			else createTcOperatorsSimple(basistc,basis);
 		}
 
-		void createTcOperatorsSimple(std::vector<SparseMatrixType>& basistc,
+		void createTcOperatorsSimple(std::vector<SparseMatrixType*>& basistc,
 		                       const BasisWithOperatorsType& basis)
 		{
-			for (size_t i=0;i<basistc.size();i++)
-				transposeConjugate(basistc[i],basis.getOperatorByIndex(i).data);
+			for (size_t i=0;i<basistc.size();i++) {
+				const SparseMatrixType& tmp = basis.getOperatorByIndex(i).data;
+				if (tmp.row()==0) continue;
+				basistc[i] = ArenaType::acquire();
+				transposeConjugate(*basistc[i],tmp);
+			}
 		}
 
-		void createTcOperatorsCached(std::vector<SparseMatrixType>& basistc,
-							   const BasisWithOperatorsType& basis)
+		void createTcOperatorsCached(std::vector<SparseMatrixType*>& basistc,
+							   const BasisWithOperatorsType& basis,
+							   size_t n)
 		{
-			if (basistc.size()==0) return;
-			size_t n=basis.getOperatorByIndex(0).data.row();
 			std::vector<std::vector<int> > col(n);
 			std::vector<std::vector<typename SparseMatrixType::value_type> > value(n);
 			for (size_t i=0;i<basistc.size();i++) {
 				const SparseMatrixType& tmp = basis.getOperatorByIndex(i).data;
+				if (tmp.row()==0) continue;
 				assert(tmp.row()==n);
-				transposeConjugate(basistc[i],tmp,col,value);
+				basistc[i] = ArenaType::acquire();
+				transposeConjugate(*basistc[i],tmp,col,value);
 
 			}
 		}
@@ -469,7 +681,11 @@ namespace Dmrg {
 				pack.unpack(alpha_[i],beta_[i],lrs_.super().permutation(i+offset));
 			}
 		}
+		static bool useBlockedKernel_;
 	}; // class ModelHelperLocal
+
+	template<typename LeftRightSuperType_,typename ConcurrencyType_>
+	bool ModelHelperLocal<LeftRightSuperType_,ConcurrencyType_>::useBlockedKernel_=false;
 } // namespace Dmrg
 /*@}*/
 
@@ -77,6 +77,7 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "ClebschGordanCached.h"
 #include "Su2Reduced.h"
 #include "Link.h"
+#include "LinkProductStruct.h"
 
 /** \ingroup DMRG */
 /*@{*/
@@ -112,6 +113,7 @@ namespace Dmrg {
 
 		typedef typename SparseMatrixType::value_type SparseElementType;
 		typedef Link<SparseElementType,RealType> LinkType;
+		typedef LinkProductStruct<SparseMatrixType,LinkType> LinkProductStructType;
 		
 		ModelHelperSu2(int m,const LeftRightSuperType& lrs)
 		: m_(m),
@@ -121,6 +123,9 @@ namespace Dmrg {
 
 		static bool isSu2() { return true; }
 
+		//! There is only one kernel for SU(2), the flag is ignored
+		static void useBlockedKernel(bool) {}
+
 		int size() const
 		{
 			int tmp = lrs_.super().partition(m_+1)-lrs_.super().partition(m_);
@@ -219,6 +224,20 @@ namespace Dmrg {
 					SparseMatrixType const &B,
 					const LinkType& link,
 	    				bool flipped=false) const 
+		{
+			fastOpProdInter(x,y,A,B,link,0,x.size(),flipped);
+		}
+
+		//! Same as above but updates only rows [rowStart,rowEnd) of x, so that
+		//! threads owning disjoint row ranges do not need to synchronize
+		void fastOpProdInter(std::vector<SparseElementType>  &x,
+				     std::vector<SparseElementType>  const &y,
+				     SparseMatrixType const &A,
+				     SparseMatrixType const &B,
+				     const LinkType& link,
+				     size_t rowStart,
+				     size_t rowEnd,
+				     bool flipped=false) const
 		{
 			//int const SystemEnviron=1,EnvironSystem=2;
 			RealType fermionSign =  (link.fermionOrBoson==ProgramGlobals::FERMION) ? -1 : 1;
@@ -227,7 +246,7 @@ namespace Dmrg {
 				LinkType link2 = link;
 				link2.value *= fermionSign;
 				link2.type = ProgramGlobals::SYSTEM_ENVIRON; 
-				fastOpProdInter(x,y,B,A,link2,true);
+				fastOpProdInter(x,y,B,A,link2,rowStart,rowEnd,true);
 				return;
 			}
 
@@ -237,7 +256,7 @@ namespace Dmrg {
 
 			for (size_t i=0;i<su2reduced_.reducedEffectiveSize();i++) {
 				int ix = su2reduced_.flavorMapping(i)-offset;
-				if (ix<0 || ix>=int(x.size())) continue;
+				if (ix<int(rowStart) || ix>=int(rowEnd)) continue;
 
 				size_t i1=su2reduced_.reducedEffective(i).first;
 				size_t i2=su2reduced_.reducedEffective(i).second;
@@ -273,6 +292,74 @@ namespace Dmrg {
 			}
 		}
 
+		//! Same as fastOpProdInter(x,y,A,B,link,rowStart,rowEnd) but for nvectors vectors
+		//! stored interleaved: entry i of vector v is x[i*nvectors+v]
+		void fastOpProdInterVectors(std::vector<SparseElementType>  &x,
+					    std::vector<SparseElementType>  const &y,
+					    SparseMatrixType const &A,
+					    SparseMatrixType const &B,
+					    const LinkType& link,
+					    size_t rowStart,
+					    size_t rowEnd,
+					    size_t nvectors,
+					    bool flipped=false) const
+		{
+			RealType fermionSign =  (link.fermionOrBoson==ProgramGlobals::FERMION) ? -1 : 1;
+
+			if (link.type == ProgramGlobals::ENVIRON_SYSTEM)  {
+				LinkType link2 = link;
+				link2.value *= fermionSign;
+				link2.type = ProgramGlobals::SYSTEM_ENVIRON;
+				fastOpProdInterVectors(x,y,B,A,link2,rowStart,rowEnd,nvectors,true);
+				return;
+			}
+
+			//! work only on partition m
+			int m = m_;
+			int offset = lrs_.super().partition(m);
+			int n = y.size()/nvectors;
+
+			for (size_t i=0;i<su2reduced_.reducedEffectiveSize();i++) {
+				int ix = su2reduced_.flavorMapping(i)-offset;
+				if (ix<int(rowStart) || ix>=int(rowEnd)) continue;
+
+				size_t i1=su2reduced_.reducedEffective(i).first;
+				size_t i2=su2reduced_.reducedEffective(i).second;
+				PairType jm1 = lrs_.left().jmValue(lrs_.left().reducedIndex(i1));
+				size_t n1=lrs_.left().electrons(lrs_.left().reducedIndex(i1));
+				RealType fsign=1;
+
+				if (n1>0 && n1%2!=0) fsign= fermionSign;
+
+				PairType jm2 = lrs_.right().jmValue(lrs_.right().reducedIndex(i2));
+				size_t lf1 =jm1.first + jm2.first*lrs_.left().jMax();
+				SparseElementType* xi = &(x[ix*nvectors]);
+
+				for (int k1=A.getRowPtr(i1);k1<A.getRowPtr(i1+1);k1++) {
+					size_t i1prime = A.getCol(k1);
+					PairType jm1prime = lrs_.left().jmValue(lrs_.left().reducedIndex(i1prime));
+
+					for (int k2=B.getRowPtr(i2);k2<B.getRowPtr(i2+1);k2++) {
+						size_t i2prime = B.getCol(k2);
+						PairType jm2prime = lrs_.right().jmValue(lrs_.right().reducedIndex(i2prime));
+						SparseElementType lfactor;
+						size_t lf2 =jm1prime.first + jm2prime.first*lrs_.left().jMax();
+
+						lfactor=su2reduced_.reducedFactor(link.angularMomentum,link.category,flipped,lf1,lf2);
+						if (lfactor==static_cast<SparseElementType>(0)) continue;
+						lfactor *= link.angularFactor;
+
+						int jx = su2reduced_.flavorMapping(i1prime,i2prime)-offset;
+						if (jx<0 || jx >= n) continue;
+
+						SparseElementType f = fsign*link.value*lfactor*A.getValue(k1)*B.getValue(k2);
+						const SparseElementType* yj = &(y[jx*nvectors]);
+						for (size_t v=0;v<nvectors;v++) xi[v] += f*yj[v];
+					}
+				}
+			}
+		}
+
 		//! Let H_{alpha,beta; alpha',beta'} = basis2.hamiltonian_{alpha,alpha'} \delta_{beta,beta'}
 		//! Let H_m be  the m-th block (in the ordering of basis1) of H
 		//! Then, this function does x += H_m * y
@@ -280,6 +367,15 @@ namespace Dmrg {
 		//! Has been changed to accomodate for reflection symmetry
 		void hamiltonianLeftProduct(std::vector<SparseElementType> &x,std::vector<SparseElementType> const &y) const 
 		{ 
+			hamiltonianLeftProduct(x,y,0,x.size());
+		}
+
+		//! Same as above but only for rows [rowStart,rowEnd) of x
+		void hamiltonianLeftProduct(std::vector<SparseElementType> &x,
+					    std::vector<SparseElementType> const &y,
+					    size_t rowStart,
+					    size_t rowEnd) const
+		{
 			//! work only on partition m
 			int m = m_;
 			int offset = lrs_.super().partition(m);
@@ -287,7 +383,7 @@ namespace Dmrg {
 
 			for (size_t i=0;i<su2reduced_.reducedEffectiveSize();i++) {
 				int ix = su2reduced_.flavorMapping(i)-offset;
-				if (ix<0 || ix>=int(x.size())) continue;
+				if (ix<int(rowStart) || ix>=int(rowEnd)) continue;
 
 				size_t i1=su2reduced_.reducedEffective(i).first;
 				size_t i2=su2reduced_.reducedEffective(i).second;
@@ -309,12 +405,59 @@ namespace Dmrg {
 			}
 		}
 
+		//! Same as above but for nvectors vectors stored interleaved, see fastOpProdInterVectors
+		void hamiltonianLeftProductVectors(std::vector<SparseElementType> &x,
+						   std::vector<SparseElementType> const &y,
+						   size_t rowStart,
+						   size_t rowEnd,
+						   size_t nvectors) const
+		{
+			//! work only on partition m
+			int m = m_;
+			int offset = lrs_.super().partition(m);
+			int n = y.size()/nvectors;
+			const SparseMatrixType& A = su2reduced_.hamiltonianLeft();
+
+			for (size_t i=0;i<su2reduced_.reducedEffectiveSize();i++) {
+				int ix = su2reduced_.flavorMapping(i)-offset;
+				if (ix<int(rowStart) || ix>=int(rowEnd)) continue;
+
+				size_t i1=su2reduced_.reducedEffective(i).first;
+				size_t i2=su2reduced_.reducedEffective(i).second;
+
+				PairType jm1 = lrs_.left().jmValue(lrs_.left().reducedIndex(i1));
+				PairType jm2 = lrs_.right().jmValue(lrs_.right().reducedIndex(i2));
+				SparseElementType lfactor=su2reduced_.reducedHamiltonianFactor(jm1.first,jm2.first);
+				if (lfactor==static_cast<SparseElementType>(0)) continue;
+				SparseElementType* xi = &(x[ix*nvectors]);
+
+				for (int k1=A.getRowPtr(i1);k1<A.getRowPtr(i1+1);k1++) {
+					size_t i1prime = A.getCol(k1);
+					int jx = su2reduced_.flavorMapping(i1prime,i2)-offset;
+					if (jx<0 || jx >= n) continue;
+
+					SparseElementType f = A.getValue(k1);
+					const SparseElementType* yj = &(y[jx*nvectors]);
+					for (size_t v=0;v<nvectors;v++) xi[v] += f*yj[v];
+				}
+			}
+		}
+
 		//! Let  H_{alpha,beta; alpha',beta'} = basis2.hamiltonian_{beta,beta'} \delta_{alpha,alpha'}
 		//! Let H_m be  the m-th block (in the ordering of basis1) of H
 		//! Then, this function does x += H_m * y
 		//! This is a performance critical function
 		void hamiltonianRightProduct(std::vector<SparseElementType> &x,std::vector<SparseElementType> const &y) const 
 		{ 
+			hamiltonianRightProduct(x,y,0,x.size());
+		}
+
+		//! Same as above but only for rows [rowStart,rowEnd) of x
+		void hamiltonianRightProduct(std::vector<SparseElementType> &x,
+					    std::vector<SparseElementType> const &y,
+					    size_t rowStart,
+					    size_t rowEnd) const
+		{
 			//! work only on partition m
 			int m = m_;
 			int offset = lrs_.super().partition(m);
@@ -322,7 +465,7 @@ namespace Dmrg {
 
 			for (size_t i=0;i<su2reduced_.reducedEffectiveSize();i++) {
 				int ix = su2reduced_.flavorMapping(i)-offset;
-				if (ix<0 || ix>=int(x.size())) continue;
+				if (ix<int(rowStart) || ix>=int(rowEnd)) continue;
 
 				size_t i1=su2reduced_.reducedEffective(i).first;
 				size_t i2=su2reduced_.reducedEffective(i).second;
@@ -342,6 +485,43 @@ namespace Dmrg {
 			}
 		}
 
+		//! Same as above but for nvectors vectors stored interleaved, see fastOpProdInterVectors
+		void hamiltonianRightProductVectors(std::vector<SparseElementType> &x,
+						    std::vector<SparseElementType> const &y,
+						    size_t rowStart,
+						    size_t rowEnd,
+						    size_t nvectors) const
+		{
+			//! work only on partition m
+			int m = m_;
+			int offset = lrs_.super().partition(m);
+			int n = y.size()/nvectors;
+			const SparseMatrixType& B = su2reduced_.hamiltonianRight();
+
+			for (size_t i=0;i<su2reduced_.reducedEffectiveSize();i++) {
+				int ix = su2reduced_.flavorMapping(i)-offset;
+				if (ix<int(rowStart) || ix>=int(rowEnd)) continue;
+
+				size_t i1=su2reduced_.reducedEffective(i).first;
+				size_t i2=su2reduced_.reducedEffective(i).second;
+				PairType jm1 = lrs_.left().jmValue(lrs_.left().reducedIndex(i1));
+				PairType jm2 = lrs_.right().jmValue(lrs_.right().reducedIndex(i2));
+				SparseElementType lfactor=su2reduced_.reducedHamiltonianFactor(jm1.first,jm2.first);
+				if (lfactor==static_cast<SparseElementType>(0)) continue;
+				SparseElementType* xi = &(x[ix*nvectors]);
+
+				for (int k2=B.getRowPtr(i2);k2<B.getRowPtr(i2+1);k2++) {
+					size_t i2prime = B.getCol(k2);
+					int jx = su2reduced_.flavorMapping(i1,i2prime)-offset;
+					if (jx<0 || jx >= n) continue;
+
+					SparseElementType f = B.getValue(k2);
+					const SparseElementType* yj = &(y[jx*nvectors]);
+					for (size_t v=0;v<nvectors;v++) xi[v] += f*yj[v];
+				}
+			}
+		}
+
 		//! Note: USed only for debugging
 		void calcHamiltonianPartLeft(SparseMatrixType &matrixBlock) const
 		{
@@ -434,10 +614,18 @@ namespace Dmrg {
 			return lrs_;
 		}
 
+		//! The connection plan of partition m, filled by the model on first use
+		LinkProductStructType& linkProductStruct() const
+		{
+			return lps_;
+		}
+
 	private:
+
 		int m_;
 		const LeftRightSuperType&  lrs_;
 		Su2Reduced<LeftRightSuperType,ConcurrencyType_> su2reduced_;
+		mutable LinkProductStructType lps_;
 	};
 } // namespace Dmrg
 /*@}*/
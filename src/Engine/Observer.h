@@ -134,7 +134,8 @@ namespace Dmrg {
 				const ModelType& model,
 				ConcurrencyType& concurrency,
 				bool verbose=false)
-		: helper_(io,nf,model.params().nthreads,hasTimeEvolution,verbose),
+		: helper_(io,nf,model.params().nthreads,hasTimeEvolution,
+			  model.params().observerMemoryBudget,verbose),
 		  concurrency_(concurrency),
 		  verbose_(verbose),
 		  onepoint_(helper_),
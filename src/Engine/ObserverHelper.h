@@ -78,6 +78,15 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
  *
  *  A class to read and serve precomputed data to the observer
  *
+ *  By default all steps of a sweep are read up front. With a memory
+ *  budget and a binary data file (see IoBinaryFile) steps are instead
+ *  read by index when a thread first points to them, and the least
+ *  recently used steps are dropped when over budget. The step each
+ *  thread points to is never dropped, so references returned by the
+ *  accessors stay valid until that thread calls setPointer again;
+ *  CorrelationsSkeleton::growDirectly moves the pointer one step at
+ *  a time, so the budget should hold a few steps per thread
+ *
  */
 #ifndef PRECOMPUTED_H
 #define PRECOMPUTED_H
@@ -87,6 +96,10 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "DmrgSerializer.h"
 #include "VectorWithOffsets.h" // to include norm
 #include "VectorWithOffset.h" // to include norm
+#include "IoBinaryFile.h"
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#endif
 
 namespace Dmrg {
 	template<
@@ -121,6 +134,7 @@ namespace Dmrg {
 				size_t nf,
 				size_t numberOfPthreads,
 				bool hasTimeEvolution,
+				size_t memoryBudget,
 				bool verbose)
 			:	io_(io),
 				dSerializerV_(),//(1,DmrgSerializerType(io_,true)),
@@ -128,9 +142,19 @@ namespace Dmrg {
 				currentPos_(numberOfPthreads),
 				verbose_(verbose),
 				bracket_(2,GS_VECTOR),
-				noMoreData_(false)
+				noMoreData_(false),
+				hasTimeEvolution_(hasTimeEvolution),
+				streaming_(false),
+				firstStep_(0),
+				budget_(memoryBudget*1024*1024),
+				bytesLoaded_(0),
+				tick_(0)
 		{
-			if (!init(hasTimeEvolution,nf)) throw std::runtime_error(
+#ifdef USE_PTHREADS
+			pthread_mutex_init(&mutex_,0);
+#endif
+			bool ok = (budget_>0) ? initStreaming(io_,nf) : init(hasTimeEvolution,nf);
+			if (!ok) throw std::runtime_error(
 					"No more data to construct this object\n");
 
 		}
@@ -141,6 +165,13 @@ namespace Dmrg {
 				DmrgSerializerType* p = dSerializerV_[i];
 				delete p;
 			}
+			for (size_t i=0;i<timeSerializerV_.size();i++) {
+				TimeSerializerType* p = timeSerializerV_[i];
+				delete p;
+			}
+#ifdef USE_PTHREADS
+			pthread_mutex_destroy(&mutex_);
+#endif
 		}
 		
 		bool endOfData() const { return noMoreData_; }
@@ -148,7 +179,25 @@ namespace Dmrg {
 		void setPointer(size_t threadId,size_t pos)
 		{
 			assert(threadId<currentPos_.size());
+			if (!streaming_) {
+				currentPos_[threadId]=pos;
+				return;
+			}
+#ifdef USE_PTHREADS
+			pthread_mutex_lock(&mutex_);
+#endif
 			currentPos_[threadId]=pos;
+			try {
+				if (pos<dSerializerV_.size()) use(pos);
+			} catch (std::exception& e) {
+#ifdef USE_PTHREADS
+				pthread_mutex_unlock(&mutex_);
+#endif
+				throw;
+			}
+#ifdef USE_PTHREADS
+			pthread_mutex_unlock(&mutex_);
+#endif
 		}
 
 		size_t getPointer(size_t threadId) const
@@ -219,15 +268,15 @@ namespace Dmrg {
 		RealType time(size_t threadId) const
 		{
 			checkPos(threadId);
-			return timeSerializerV_[currentPos_[threadId]].time();
+			return timeSerializerV_[currentPos_[threadId]]->time();
 		}
 
 		size_t site(size_t threadId) const
 		{
 			checkPos(threadId);
-			return  (timeSerializerV_.size()==0) ?
+			return  (!hasTimeEvolution_) ?
 						dSerializerV_[currentPos_[threadId]]->site()
-					  : timeSerializerV_[currentPos_[threadId]].site();
+					  : timeSerializerV_[currentPos_[threadId]]->site();
 		}
 		
 		size_t size() const
@@ -238,7 +287,7 @@ namespace Dmrg {
 		size_t marker(size_t threadId) const
 		{
 			checkPos(threadId);
-			return timeSerializerV_[currentPos_[threadId]].marker();
+			return timeSerializerV_[currentPos_[threadId]]->marker();
 		}
 
 		const VectorWithOffsetType& getVectorFromBracketId(size_t leftOrRight,size_t threadId) const
@@ -252,7 +301,7 @@ namespace Dmrg {
 		const VectorWithOffsetType& timeVector(size_t threadId) const
 		{
 			checkPos(threadId);
-			return timeSerializerV_[currentPos_[threadId]].vector();
+			return timeSerializerV_[currentPos_[threadId]]->vector();
 		}
 
 		template<typename IoInputType1,typename MatrixType1,
@@ -284,7 +333,7 @@ namespace Dmrg {
 						DmrgSerializerType(io_);
 					if (counter>=offset) dSerializerV_.push_back(dSerializer);
 					if (hasTimeEvolution) {
-						TimeSerializerType ts(io_);
+						TimeSerializerType* ts = new TimeSerializerType(io_);
 						if (counter>=offset) timeSerializerV_.push_back(ts);
 					}
 					counter++;
@@ -301,6 +350,92 @@ namespace Dmrg {
 			return true;
 		}
 
+		//! takes the next nf steps of the binary data file, without reading them
+		bool initStreaming(IoBinaryFile::In& io,size_t nf)
+		{
+			streaming_ = true;
+			firstStep_ = io.currentStep();
+			size_t count = io.size() - firstStep_;
+			if (nf>0 && count>=nf) count = nf;
+			else noMoreData_ = true;
+			if (count==0) return false;
+
+			dSerializerV_.resize(count,0);
+			if (hasTimeEvolution_) timeSerializerV_.resize(count,0);
+			lastUse_.resize(count,0);
+			bytes_.resize(count,0);
+			// the next sweep starts after this one
+			io.seek(firstStep_+count);
+			// all threads start pointing to the first step
+			use(0);
+			return true;
+		}
+
+		//! only the binary data file has an index of steps
+		template<typename SomeIoInputType>
+		bool initStreaming(SomeIoInputType&,size_t nf)
+		{
+			std::cerr<<"ObserverHelper: a memory budget needs the binaryData option, ignored\n";
+			return init(hasTimeEvolution_,nf);
+		}
+
+		void use(size_t pos)
+		{
+			lastUse_[pos] = ++tick_;
+			if (dSerializerV_[pos]) return;
+			loadStep(io_,pos);
+			bytesLoaded_ += bytes_[pos];
+			if (verbose_)
+				std::cerr<<"ObserverHelper: loaded step "<<(firstStep_+pos)<<"\n";
+			while (bytesLoaded_>budget_) {
+				if (!evictOne()) break;
+			}
+		}
+
+		void loadStep(IoBinaryFile::In& io,size_t pos)
+		{
+			IoBinary::In step = io.step(firstStep_+pos);
+			dSerializerV_[pos] = new DmrgSerializerType(step);
+			if (hasTimeEvolution_) timeSerializerV_[pos] = new TimeSerializerType(step);
+			bytes_[pos] = io.stepBytes(firstStep_+pos);
+		}
+
+		template<typename SomeIoInputType>
+		void loadStep(SomeIoInputType&,size_t)
+		{
+			std::string str(__FILE__);
+			str += " " + ttos(__LINE__) + "\n";
+			str += " loading steps by index needs the binary data file\n";
+			throw std::runtime_error(str.c_str());
+		}
+
+		//! drops the least recently used step that no thread points to
+		bool evictOne()
+		{
+			size_t victim = dSerializerV_.size();
+			for (size_t i=0;i<dSerializerV_.size();i++) {
+				if (!dSerializerV_[i] || pointedTo(i)) continue;
+				if (victim==dSerializerV_.size() || lastUse_[i]<lastUse_[victim])
+					victim = i;
+			}
+			if (victim==dSerializerV_.size()) return false;
+			delete dSerializerV_[victim];
+			dSerializerV_[victim] = 0;
+			if (hasTimeEvolution_) {
+				delete timeSerializerV_[victim];
+				timeSerializerV_[victim] = 0;
+			}
+			bytesLoaded_ -= bytes_[victim];
+			return true;
+		}
+
+		bool pointedTo(size_t pos) const
+		{
+			for (size_t i=0;i<currentPos_.size();i++)
+				if (currentPos_[i]==pos) return true;
+			return false;
+		}
+
 		void integrityChecks()
 		{
 			if (dSerializerV_.size()!=timeSerializerV_.size()) throw std::runtime_error("Error 1\n");
@@ -308,7 +443,7 @@ namespace Dmrg {
 			for (size_t x=0;x<dSerializerV_.size()-1;x++) {
 				size_t n = dSerializerV_[x]->leftRightSuper().super().size();
 				if (n==0) continue;
-				if (n!=timeSerializerV_[x].size())
+				if (n!=timeSerializerV_[x]->size())
 					throw std::runtime_error("Error 2\n");
 			}
 			
@@ -341,7 +476,7 @@ namespace Dmrg {
 
 			size_t pos = currentPos_[threadId];
 
-			if (pos>=dSerializerV_.size()) checkFailed1(threadId,pos);
+			if (pos>=dSerializerV_.size() || !dSerializerV_[pos]) checkFailed1(threadId,pos);
 
 			bool hasTimeE = (timeSerializerV_.size()>0);
 
@@ -384,11 +519,22 @@ namespace Dmrg {
 
 		IoInputType& io_;
 		std::vector<DmrgSerializerType*> dSerializerV_;
-		std::vector<TimeSerializerType> timeSerializerV_;
+		std::vector<TimeSerializerType*> timeSerializerV_;
 		std::vector<size_t> currentPos_; // it's a vector: one per pthread
 		bool verbose_;
 		std::vector<size_t> bracket_;
 		bool noMoreData_;
+		bool hasTimeEvolution_;
+		bool streaming_;
+		size_t firstStep_;
+		size_t budget_; // in bytes
+		size_t bytesLoaded_;
+		size_t tick_;
+		std::vector<size_t> lastUse_;
+		std::vector<size_t> bytes_;
+#ifdef USE_PTHREADS
+		pthread_mutex_t mutex_;
+#endif
 	};  //ObserverHelper
 
 	template<
@@ -83,6 +83,7 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
  */
 #ifndef OPERATOR_H
 #define OPERATOR_H
+#include "IoBinary.h"
 
 namespace Dmrg {
 	//! This is a structure, don't add member functions here!
@@ -191,6 +192,40 @@ namespace Dmrg {
 		os<<op.su2Related;
 		return os;
 	}
+
+	inline void binaryWrite(std::string& buf,const Su2Related& x)
+	{
+		binaryWrite(buf,x.offset);
+		binaryWrite(buf,x.source);
+		binaryWrite(buf,x.transpose);
+	}
+
+	inline void binaryRead(IoBinaryBuffer& buf,Su2Related& x)
+	{
+		binaryRead(buf,x.offset);
+		binaryRead(buf,x.source);
+		binaryRead(buf,x.transpose);
+	}
+
+	template<typename RealType,typename SparseMatrixType>
+	void binaryWrite(std::string& buf,const Operator<RealType,SparseMatrixType>& op)
+	{
+		binaryWrite(buf,op.data);
+		binaryWrite(buf,op.fermionSign);
+		binaryWrite(buf,op.jm);
+		binaryWrite(buf,op.angularFactor);
+		binaryWrite(buf,op.su2Related);
+	}
+
+	template<typename RealType,typename SparseMatrixType>
+	void binaryRead(IoBinaryBuffer& buf,Operator<RealType,SparseMatrixType>& op)
+	{
+		binaryRead(buf,op.data);
+		binaryRead(buf,op.fermionSign);
+		binaryRead(buf,op.jm);
+		binaryRead(buf,op.angularFactor);
+		binaryRead(buf,op.su2Related);
+	}
 } // namespace Dmrg
 
 /*@}*/
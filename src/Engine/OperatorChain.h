@@ -0,0 +1,239 @@
+/*
+Copyright (c) 2012, UT-Battelle, LLC
+All rights reserved
+
+[DMRG++, Version 2.0.0]
+[by G.A., Oak Ridge National Laboratory]
+
+UT Battelle Open Source Software License 11242008
+
+OPEN SOURCE LICENSE
+
+Subject to the conditions of this License, each
+contributor to this software hereby grants, free of
+charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), a
+perpetual, worldwide, non-exclusive, no-charge,
+royalty-free, irrevocable copyright license to use, copy,
+modify, merge, publish, distribute, and/or sublicense
+copies of the Software.
+
+1. Redistributions of Software must retain the above
+copyright and license notices, this list of conditions,
+and the following disclaimer.  Changes or modifications
+to, or derivative works of, the Software should be noted
+with comments and the contributor and organization's
+name.
+
+2. Neither the names of UT-Battelle, LLC or the
+Department of Energy nor the names of the Software
+contributors may be used to endorse or promote products
+derived from this software without specific prior written
+permission of UT-Battelle.
+
+3. The software and the end-user documentation included
+with the redistribution, with or without modification,
+must include the following acknowledgment:
+
+"This product includes software produced by UT-Battelle,
+LLC under Contract No. DE-AC05-00OR22725  with the
+Department of Energy."
+
+*********************************************************
+DISCLAIMER
+
+THE SOFTWARE IS SUPPLIED BY THE COPYRIGHT HOLDERS AND
+CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER, CONTRIBUTORS, UNITED STATES GOVERNMENT,
+OR THE UNITED STATES DEPARTMENT OF ENERGY BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+DAMAGE.
+
+NEITHER THE UNITED STATES GOVERNMENT, NOR THE UNITED
+STATES DEPARTMENT OF ENERGY, NOR THE COPYRIGHT OWNER, NOR
+ANY OF THEIR EMPLOYEES, REPRESENTS THAT THE USE OF ANY
+INFORMATION, DATA, APPARATUS, PRODUCT, OR PROCESS
+DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
+
+*********************************************************
+
+
+*/
+// END LICENSE BLOCK
+/** \ingroup DMRG */
+/*@{*/
+
+/*! \file OperatorChain.h
+ *
+ *  Changes of basis that have not yet been applied to a stored operator.
+ *  A step is either a rotation T^\dagger A T (see BlockRotation.h) or the
+ *  growth of the block by one site, that is, the external product with
+ *  the identity on the other basis followed by the reordering of the
+ *  product basis. Steps are shared by all operators of a basis, and
+ *  by all copies of it, through a reference count
+ *
+ */
+
+#ifndef OPERATOR_CHAIN_H
+#define OPERATOR_CHAIN_H
+
+#include <vector>
+#include <cassert>
+#include "BlockRotation.h"
+#include "ExternalProductReordered.h"
+
+namespace Dmrg {
+
+template<typename OperatorType>
+class OperatorChainStep {
+
+	typedef typename OperatorType::SparseMatrixType SparseMatrixType;
+	typedef BlockRotation<SparseMatrixType> BlockRotationType;
+
+public:
+
+	//! rotation by ftransform
+	OperatorChainStep(const SparseMatrixType& ftransform)
+	: rotation_(new BlockRotationType(ftransform)),x_(0),option_(false),refs_(0)
+	{}
+
+	//! external product with the identity of size x, option as in
+	//! PsimagLite::externalProduct; electrons are those of the left basis
+	OperatorChainStep(size_t x,
+			  bool option,
+			  const std::vector<size_t>& electrons,
+			  const std::vector<size_t>& permutation)
+	: rotation_(0),
+	  x_(x),
+	  option_(option),
+	  electrons_(electrons),
+	  permutation_(permutation),
+	  refs_(0)
+	{
+		invertPermutation(permutationInverse_,permutation_);
+	}
+
+	~OperatorChainStep()
+	{
+		delete rotation_;
+	}
+
+	void apply(OperatorType& op) const
+	{
+		if (rotation_) {
+			(*rotation_)(op.data);
+			return;
+		}
+
+		std::vector<double> fermionicSigns(electrons_.size());
+		for (size_t i=0;i<fermionicSigns.size();i++)
+			fermionicSigns[i] = (electrons_[i]%2==0) ? 1.0 : static_cast<double>(op.fermionSign);
+
+		SparseMatrixType tmp;
+		externalProductReordered(tmp,op.data,x_,fermionicSigns,option_,
+					 permutation_,permutationInverse_);
+		op.data = tmp;
+	}
+
+	//! only for rotation steps
+	void rotate(SparseMatrixType& m) const
+	{
+		assert(rotation_);
+		(*rotation_)(m);
+	}
+
+	void ref() const { refs_++; }
+
+	//! returns true if this was the last reference
+	bool unref() const
+	{
+		refs_--;
+		return (refs_==0);
+	}
+
+private:
+
+	OperatorChainStep(const OperatorChainStep&);
+
+	OperatorChainStep& operator=(const OperatorChainStep&);
+
+	BlockRotationType* rotation_;
+	size_t x_;
+	bool option_;
+	std::vector<size_t> electrons_;
+	std::vector<size_t> permutation_;
+	std::vector<size_t> permutationInverse_;
+	mutable size_t refs_;
+}; // class OperatorChainStep
+
+//! The steps pending on one operator, oldest first
+template<typename OperatorType>
+class OperatorChain {
+
+public:
+
+	typedef OperatorChainStep<OperatorType> StepType;
+
+	OperatorChain() {}
+
+	OperatorChain(const OperatorChain& other)
+	: steps_(other.steps_)
+	{
+		for (size_t i=0;i<steps_.size();i++) steps_[i]->ref();
+	}
+
+	OperatorChain& operator=(const OperatorChain& other)
+	{
+		if (this==&other) return *this;
+		for (size_t i=0;i<other.steps_.size();i++) other.steps_[i]->ref();
+		clear();
+		steps_ = other.steps_;
+		return *this;
+	}
+
+	~OperatorChain()
+	{
+		clear();
+	}
+
+	//! takes a reference to step; a step that is pushed nowhere must be
+	//! pushed here anyway so that it gets deleted
+	void push(const StepType* step)
+	{
+		step->ref();
+		steps_.push_back(step);
+	}
+
+	bool empty() const { return steps_.size()==0; }
+
+	void apply(OperatorType& op)
+	{
+		for (size_t i=0;i<steps_.size();i++) steps_[i]->apply(op);
+		clear();
+	}
+
+	void clear()
+	{
+		for (size_t i=0;i<steps_.size();i++)
+			if (steps_[i]->unref()) delete steps_[i];
+		steps_.clear();
+	}
+
+private:
+
+	std::vector<const StepType*> steps_;
+}; // class OperatorChain
+} // namespace Dmrg
+
+/*@}*/
+#endif // OPERATOR_CHAIN_H
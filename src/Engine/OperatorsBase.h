@@ -86,6 +86,10 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "Range.h"
 #include <cassert>
 #include "ProgressIndicator.h"
+#include "BlockRotation.h"
+#include "OperatorChain.h"
+#include "ExternalProductReordered.h"
+#include "ProgramGlobals.h"
 
 namespace Dmrg {
 /**
@@ -112,13 +116,18 @@ transformed operator can be used (or not because of the reason limitation above)
 	class OperatorsBase {
 		
 		typedef std::pair<size_t,size_t> PairType;
-		static const bool EXCLUDE = false;
+		typedef typename OperatorType_::SparseMatrixType SparseMatrixType_;
+		typedef BlockRotation<SparseMatrixType_> BlockRotationType;
+		typedef ParallelBlockRotation<BlockRotationType,OperatorType_> ParallelBlockRotationType;
+		typedef ParallelExternalProduct<OperatorType_> ParallelExternalProductType;
 
 	public:
 		
 		typedef BasisType_ BasisType;
 		typedef OperatorType_ OperatorType;
 		typedef typename OperatorType::SparseMatrixType SparseMatrixType;
+		typedef OperatorChain<OperatorType> OperatorChainType;
+		typedef typename OperatorChainType::StepType OperatorChainStepType;
 
 		OperatorsBase(const BasisType* thisBasis)
 		: useSu2Symmetry_(BasisType::useSu2Symmetry()),
@@ -135,6 +144,7 @@ transformed operator can be used (or not because of the reason limitation above)
 		  progress_("Operators",0)
 		{
 			if (!useSu2Symmetry_) io.read(operators_,"#OPERATORS");
+			pending_.resize(operators_.size());
 
 			io.readMatrix(hamiltonian_,"#HAMILTONIAN");
 			reducedOpImpl_.setHamiltonian(hamiltonian_);
@@ -146,6 +156,8 @@ transformed operator can be used (or not because of the reason limitation above)
 			if (!useSu2Symmetry_)
 				io.read(operators_,"#OPERATORS");
 			else reducedOpImpl_.load(io);
+			pending_.clear();
+			pending_.resize(operators_.size());
 
 			io.readMatrix(hamiltonian_,"#HAMILTONIAN");
 			reducedOpImpl_.setHamiltonian(hamiltonian_);
@@ -155,6 +167,8 @@ transformed operator can be used (or not because of the reason limitation above)
 		{
 			if (!useSu2Symmetry_) operators_=ops;
 			else reducedOpImpl_.setOperators(ops);
+			pending_.clear();
+			pending_.resize(operators_.size());
 		}
 		
 		const OperatorType& getReducedOperatorByIndex(char modifier,const PairType& p) const
@@ -167,6 +181,7 @@ transformed operator can be used (or not because of the reason limitation above)
 		{
 			assert(!useSu2Symmetry_);
 			assert(i>=0 && size_t(i)<operators_.size());
+			materialize(i);
 			return operators_[i];
 		}
 
@@ -182,34 +197,61 @@ transformed operator can be used (or not because of the reason limitation above)
 			return operators_.size();
 		}
 
+		//! Without SU(2) the operators of this process are rotated with a
+		//! BlockRotation built once from ftransform, over nthreads threads
+		//! Operators with index outside [startEnd.first,startEnd.second) are
+		//! dropped, and stay so when the block grows
 		template<typename ConcurrencyType>
 		void changeBasis(const SparseMatrixType& ftransform,
 		                 const BasisType* thisBasis,
-				 ConcurrencyType &concurrency)
-// 		                 const std::pair<size_t,size_t>& startEnd)
+				 ConcurrencyType &concurrency,
+				 const PairType& startEnd,
+				 size_t nthreads = 1)
 		{
 			reducedOpImpl_.prepareTransform(ftransform,thisBasis);
 			size_t total = numberOfOperators();
 
-			PsimagLite::Range<ConcurrencyType> range(0,total,concurrency);
-			for (;!range.end();range.next()) {
-				size_t k = range.index();
-				if (isExcluded(k,thisBasis)) {
-					operators_[k].data.clear(); //resize(ftransform.n_col(),ftransform.n_col());
-					continue;
-				}
-				if (!useSu2Symmetry_) changeBasis(operators_[k].data,ftransform);
-				reducedOpImpl_.changeBasis(k);
+			if (!useSu2Symmetry_ && lazyOperators_) {
+				deferChangeBasis(ftransform,startEnd);
+				return;
 			}
 
 			if (!useSu2Symmetry_) {
+				BlockRotationType rotation(ftransform);
+				std::vector<size_t> indices;
+				PsimagLite::Range<ConcurrencyType> range(0,total,concurrency);
+				for (;!range.end();range.next()) {
+					size_t k = range.index();
+					if (isExcluded(k,startEnd)) {
+						operators_[k].data = SparseMatrixType();
+						continue;
+					}
+					indices.push_back(k);
+				}
+
+				ParallelBlockRotationType helper(rotation,operators_,indices);
+				// range already split the operators over processes
+				LOCAL_PTHREADS_NAME<ParallelBlockRotationType>::setThreads(nthreads);
+				LOCAL_PTHREADS_NAME<ParallelBlockRotationType> threadedRotation;
+				threadedRotation.loopCreate(indices.size(),helper,concurrency);
+
 				gather(operators_,concurrency);
 				broadcast(operators_,concurrency);
-			} else {
-				reducedOpImpl_.gather(concurrency);
-				reducedOpImpl_.broadcast(concurrency);
+
+				rotation(hamiltonian_);
+				return;
 			}
 
+			PsimagLite::Range<ConcurrencyType> range(0,total,concurrency);
+			for (;!range.end();range.next()) {
+				size_t k = range.index();
+				if (isExcluded(k,startEnd)) continue;
+				reducedOpImpl_.changeBasis(k);
+			}
+
+			reducedOpImpl_.gather(concurrency);
+			reducedOpImpl_.broadcast(concurrency);
+
 			changeBasis(hamiltonian_,ftransform);
 			reducedOpImpl_.changeBasisHamiltonian();
 		}
@@ -225,6 +267,9 @@ transformed operator can be used (or not because of the reason limitation above)
 		void reorder(const std::vector<size_t>& permutation)
 		{
 			for (size_t k=0;k<numberOfOperators();k++) {
+				// deferred operators have the reordering in their growth step
+				// and dropped operators stay empty
+				if (!useSu2Symmetry_ && (isPending(k) || isDropped(k))) continue;
 				if (!useSu2Symmetry_) reorder(operators_[k].data,permutation);
 				reducedOpImpl_.reorder(k,permutation);
 			}
@@ -240,9 +285,31 @@ transformed operator can be used (or not because of the reason limitation above)
 		void setToProduct(const BasisType& basis2,const BasisType& basis3,size_t x,const BasisType* thisBasis)
 		{
 			if (!useSu2Symmetry_) operators_.resize(x);
+			pending_.clear();
+			pending_.resize(operators_.size());
 			reducedOpImpl_.setToProduct(basis2,basis3,x,thisBasis);
 		}
 
+		//! Operator i becomes operator j of other, with the growth step
+		//! appended to its pending changes instead of being applied
+		void externalProductDeferred(size_t i,
+		                             const OperatorsBase& other,
+		                             size_t j,
+		                             const OperatorChainStepType* step)
+		{
+			assert(!useSu2Symmetry_);
+			operators_[i] = other.operators_[j];
+			if (operators_[i].data.row()==0) return; // dropped, see changeBasis
+			if (j<other.pending_.size()) pending_[i] = other.pending_[j];
+			pending_[i].push(step);
+		}
+
+		static bool lazyOperators() { return lazyOperators_; }
+
+		//! If set, changes of basis and growth steps are recorded for each
+		//! operator and only applied when the operator is asked for
+		static void lazyOperators(bool flag) { lazyOperators_ = flag; }
+
 		/**
 		I will know explain how the full outer product between two operators
 		is implemented. If local operator $A$ lives in Hilbert space
@@ -276,6 +343,11 @@ transformed operator can be used (or not because of the reason limitation above)
 		                     ApplyFactorsType& apply)
 		{
 			assert(!useSu2Symmetry_);
+			if (m.data.row()==0) {
+				// dropped, see changeBasis
+				operators_[i] = m;
+				return;
+			}
 			PsimagLite::externalProduct(operators_[i].data,m.data,x,fermionicSigns,option);
 			// don't forget to set fermion sign and j:
 			operators_[i].fermionSign=m.fermionSign;
@@ -284,6 +356,32 @@ transformed operator can be used (or not because of the reason limitation above)
 			apply(operators_[i].data);
 		}
 
+		//! Without SU(2): operator i becomes the external product of *sources[i]
+		//! with the identity, the first nLeft sources being on the left basis,
+		//! written directly in the order given by permutation, over nthreads threads
+		template<typename ConcurrencyType>
+		void externalProductReordered(const std::vector<const OperatorType*>& sources,
+		                              size_t nLeft,
+		                              size_t sizeLeft,
+		                              size_t sizeRight,
+		                              const std::vector<size_t>& electronsLeft,
+		                              const std::vector<size_t>& permutation,
+		                              ConcurrencyType& concurrency,
+		                              size_t nthreads = 1)
+		{
+			assert(!useSu2Symmetry_);
+			assert(sources.size()==operators_.size());
+			std::vector<size_t> permutationInverse;
+			invertPermutation(permutationInverse,permutation);
+
+			ParallelExternalProductType helper(operators_,sources,nLeft,sizeLeft,sizeRight,
+			                                   electronsLeft,permutation,permutationInverse);
+			// every process needs all the operators, and there is no gather
+			LOCAL_PTHREADS_NAME<ParallelExternalProductType>::setThreads(nthreads);
+			LOCAL_PTHREADS_NAME<ParallelExternalProductType> threadedProduct;
+			threadedProduct.loopCreate(sources.size(),helper,concurrency);
+		}
+
 		void externalProductReduced(size_t i,
 		                            const BasisType& basis2,
 		                            const BasisType& basis3,
@@ -308,6 +406,25 @@ transformed operator can be used (or not because of the reason limitation above)
 			apply(hamiltonian_);
 		}
 
+		//! Without SU(2): as outerProductHamiltonian followed by reorder,
+		//! without the temporaries of the reordering
+		void outerProductHamiltonianReordered(const SparseMatrixType& h2,
+		                                      const SparseMatrixType& h3,
+		                                      const std::vector<size_t>& permutation)
+		{
+			assert(!useSu2Symmetry_);
+			assert(h2.row()==h2.col());
+			std::vector<size_t> permutationInverse;
+			invertPermutation(permutationInverse,permutation);
+			std::vector<double> ones(h2.row(),1.0);
+			SparseMatrixType tmpMatrix;
+			externalProductReordered(hamiltonian_,h2,h3.row(),ones,true,
+			                         permutation,permutationInverse);
+			externalProductReordered(tmpMatrix,h3,h2.row(),ones,false,
+			                         permutation,permutationInverse);
+			hamiltonian_ += tmpMatrix;
+		}
+
 		void outerProductHamiltonianReduced(const BasisType& basis2,
 		                                    const BasisType& basis3,
 		                                    const SparseMatrixType& h2,
@@ -324,6 +441,15 @@ transformed operator can be used (or not because of the reason limitation above)
 
 		const SparseMatrixType& hamiltonian() const { return hamiltonian_; }
 
+		//! In-place access to the Hamiltonian, avoids a full copy when adding
+		//! connections; call hamiltonianChanged() when done
+		SparseMatrixType& hamiltonianNonConst() { return hamiltonian_; }
+
+		void hamiltonianChanged()
+		{
+			reducedOpImpl_.setHamiltonian(hamiltonian_);
+		}
+
 		const SparseMatrixType& reducedHamiltonian() const
 		{
 			return reducedOpImpl_.hamiltonian();
@@ -334,6 +460,7 @@ transformed operator can be used (or not because of the reason limitation above)
 		void print(int ind= -1) const
 		{
 			if (!useSu2Symmetry_) {
+				materializeAll();
 				if (ind<0) for (size_t i=0;i<operators_.size();i++) std::cerr<<operators_[i];
 				else std::cerr<<operators_[ind];
 			} else {
@@ -344,13 +471,64 @@ transformed operator can be used (or not because of the reason limitation above)
 		template<typename IoOutputter>
 		void save(IoOutputter& io,const std::string& s) const
 		{
-			if (!useSu2Symmetry_) io.printVector(operators_,"#OPERATORS");
-			else reducedOpImpl_.save(io,s);
+			if (!useSu2Symmetry_) {
+				materializeAll();
+				io.printVector(operators_,"#OPERATORS");
+			} else {
+				reducedOpImpl_.save(io,s);
+			}
+			io.printMatrix(hamiltonian_,"#HAMILTONIAN");
+		}
+
+		//! as save, but with no operators; loads back as a block
+		//! with a Hamiltonian and no operators
+		template<typename IoOutputter>
+		void saveWithoutOperators(IoOutputter& io) const
+		{
+			std::vector<OperatorType> none;
+			io.printVector(none,"#OPERATORS");
 			io.printMatrix(hamiltonian_,"#HAMILTONIAN");
 		}
 
 	private:
 
+		bool isPending(size_t k) const
+		{
+			return (k<pending_.size() && !pending_[k].empty());
+		}
+
+		void materialize(size_t k) const
+		{
+			if (!isPending(k)) return;
+			if (isDropped(k)) {
+				pending_[k].clear();
+				return;
+			}
+			pending_[k].apply(operators_[k]);
+		}
+
+		void materializeAll() const
+		{
+			for (size_t k=0;k<operators_.size();k++) materialize(k);
+		}
+
+		void deferChangeBasis(const SparseMatrixType& ftransform,const PairType& startEnd)
+		{
+			OperatorChainType owner;
+			OperatorChainStepType* step = new OperatorChainStepType(ftransform);
+			owner.push(step);
+			pending_.resize(operators_.size());
+			for (size_t k=0;k<operators_.size();k++) {
+				if (isExcluded(k,startEnd)) {
+					operators_[k].data = SparseMatrixType();
+					pending_[k].clear();
+					continue;
+				}
+				pending_[k].push(step);
+			}
+			step->rotate(hamiltonian_);
+		}
+
 		void reorder(SparseMatrixType &v,const std::vector<size_t>& permutation)
 		{
 			SparseMatrixType matrixTmp;
@@ -359,21 +537,28 @@ transformed operator can be used (or not because of the reason limitation above)
 			permuteInverse(v,matrixTmp,permutation);
 		}
 
-		bool isExcluded(size_t k,
-			       const BasisType* thisBasis)
-// 		               const std::pair<size_t,size_t>& startEnd)
+		bool isExcluded(size_t k,const PairType& startEnd) const
 		{
-			if (!EXCLUDE) return false; // <-- this is the safest answer
-// 			if (k<startEnd.first || k>=startEnd.second) return true;
-			return false;
+			return (k<startEnd.first || k>=startEnd.second);
+		}
+
+		//! true if the operator was dropped by changeBasis
+		bool isDropped(size_t k) const
+		{
+			return (!useSu2Symmetry_ && operators_[k].data.row()==0);
 		}
 
 		bool useSu2Symmetry_;
 		ReducedOperators<OperatorType,BasisType> reducedOpImpl_;
-		std::vector<OperatorType> operators_;
+		mutable std::vector<OperatorType> operators_;
+		mutable std::vector<OperatorChainType> pending_;
 		SparseMatrixType hamiltonian_;
 		PsimagLite::ProgressIndicator progress_;
+		static bool lazyOperators_;
 	}; //class OperatorsBase 
+
+	template<typename OperatorType_,typename BasisType_>
+	bool OperatorsBase<OperatorType_,BasisType_>::lazyOperators_ = false;
 } // namespace Dmrg
 
 /*@}*/
@@ -80,6 +80,7 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #define PARALLEL_DENSITY_MATRIX_H
 
 #include "ProgramGlobals.h"
+#include "BLAS.h"
 
 
 namespace Dmrg {
@@ -97,33 +98,83 @@ namespace Dmrg {
 
 		typedef RealType_ RealType;
 
+		//! Work items are the pairs (partition m, target t), with m slowest;
+		//! t=0 is the ground state if the targetting includes it
 		ParallelDensityMatrix(const TargettingType& target,
 							  const BasisWithOperatorsType& pBasis,
 							  const BasisWithOperatorsType& pBasisSummed,
 							  const BasisType& pSE,
 							  int direction,
-							  size_t m,
-							  BuildingBlockType& matrixBlock)
+							  size_t nthreads)
 		: target_(target),
 		  pBasis_(pBasis),
 		  pBasisSummed_(pBasisSummed),
 		  pSE_(pSE),
 		  direction_(direction),
-		  m_(m),
-		  matrixBlock_(matrixBlock)
+		  gsOffset_((target.includeGroundStage()) ? 1 : 0),
+		  targets_(target.size() + gsOffset_),
+		  firstBlock_(nthreads,0),
+		  partial_(nthreads)
 		{}
 
+		size_t size() const
+		{
+			return (pBasis_.partition()-1)*targets_;
+		}
+
+		//! Each thread accumulates into its own copies of the blocks it
+		//! touches; since loopCreate hands out contiguous ranges of items
+		//! these are a few consecutive partitions per thread
 		void thread_function_(size_t threadNum,size_t blockSize,size_t total,pthread_mutex_t* myMutex)
 		{
+			std::vector<BuildingBlockType>& partial = partial_[threadNum];
 			for (size_t p=0;p<blockSize;p++) {
 				size_t ix = threadNum * blockSize + p;
-				if (ix>=target_.size()) break;
-				RealType w = target_.weight(ix)/target_.normSquared(ix);
-				initPartition(matrixBlock_,pBasis_,m_,target_(ix),
+				if (ix>=total) break;
+				size_t m = ix/targets_;
+				size_t t = ix % targets_;
+				if (partial.size()==0) firstBlock_[threadNum] = m;
+				while (firstBlock_[threadNum] + partial.size()<=m) {
+					size_t bs = pBasis_.partition(m+1)-pBasis_.partition(m);
+					partial.push_back(BuildingBlockType(bs,bs));
+				}
+				BuildingBlockType& matrixBlock = partial[m-firstBlock_[threadNum]];
+				if (t<gsOffset_) {
+					initPartition(matrixBlock,pBasis_,m,target_.gs(),
+								  pBasisSummed_,pSE_,direction_,target_.gsWeight());
+					continue;
+				}
+				size_t i = t - gsOffset_;
+				RealType w = target_.weight(i)/target_.normSquared(i);
+				initPartition(matrixBlock,pBasis_,m,target_(i),
 							  pBasisSummed_,pSE_,direction_,w);
 			}
 		}
 
+		//! Sums the per-thread blocks in thread order, so that the result
+		//! does not depend on scheduling, and sets them into data
+		void reduce(BlockMatrixType& data) const
+		{
+			for (size_t m=0;m<pBasis_.partition()-1;m++) {
+				size_t bs = pBasis_.partition(m+1)-pBasis_.partition(m);
+				BuildingBlockType matrixBlock(bs,bs);
+				for (size_t thread=0;thread<partial_.size();thread++) {
+					const std::vector<BuildingBlockType>& partial = partial_[thread];
+					size_t first = firstBlock_[thread];
+					if (m<first || m>=first+partial.size()) continue;
+					const BuildingBlockType& src = partial[m-first];
+					for (size_t j=0;j<bs;j++)
+						for (size_t i=0;i<bs;i++)
+							matrixBlock(i,j) += src(i,j);
+				}
+				data.setBlock(m,pBasis_.partition(m),matrixBlock);
+			}
+		}
+
+		//! Adds weight * psi psi^\dagger to matrixBlock, where psi(i,beta) is the
+		//! component of v on state i of partition m of pBasis times state beta of
+		//! pBasisSummed. psi is gathered densely, skipping the columns beta that are
+		//! zero, and the product is a single GEMM
 		void initPartition(BuildingBlockType& matrixBlock,
 						   BasisWithOperatorsType const &pBasis,
 						   size_t m,
@@ -133,108 +184,48 @@ namespace Dmrg {
 						   size_t direction,
 						   RealType weight)
 		{
-			if (direction!=ProgramGlobals::EXPAND_SYSTEM)
-				initPartitionExpandEnviron(matrixBlock,pBasis,m,v,pBasisSummed,pSE,weight);
-			else
-				initPartitionExpandSystem(matrixBlock,pBasis,m,v,pBasisSummed,pSE,weight);
-		}
-
-	private:
-
-		void initPartitionExpandEnviron(BuildingBlockType& matrixBlock,
-										BasisWithOperatorsType const &pBasis,
-										size_t m,
-										const TargetVectorType& v,
-										BasisWithOperatorsType const &pBasisSummed,
-										BasisType const &pSE,
-										RealType weight)
-		{
-
-			size_t ns=pBasisSummed.size();
-			size_t ne=pSE.size()/ns;
-			size_t start = pBasis.partition(m);
-			size_t length = pBasis.partition(m+1) - start;
-			size_t total=pBasisSummed.size();
-
-			for (size_t i=0;i<length;++i) {
-				size_t ieff = i +start;
-				for (size_t j=0;j<length;++j) {
-					matrixBlock(i,j) += densityMatrixExpandEnviron(ieff,j+start,v,total,pSE,ns,ne)*weight;
-				}
-			}
-		}
-
-		void initPartitionExpandSystem(BuildingBlockType& matrixBlock,
-									   BasisWithOperatorsType const &pBasis,
-									   size_t m,
-									   const TargetVectorType& v,
-									   BasisWithOperatorsType const &pBasisSummed,
-									   BasisType const &pSE,
-									   RealType weight)
-		{
-			size_t ne = pBasisSummed.size();
-			size_t ns = pSE.size()/ne;
 			size_t start = pBasis.partition(m);
 			size_t length = pBasis.partition(m+1) - start;
-			size_t total=pBasisSummed.size();
-
-			for (size_t i=0;i<length;++i) {
-				size_t ieff = i +start;
-				for (size_t j=0;j<length;++j) {
-					matrixBlock(i,j) += densityMatrixExpandSystem(ieff,j+start,v,total,pSE,ns,ne)*weight;
+			size_t total = pBasisSummed.size();
+			bool expandSystem = (direction==ProgramGlobals::EXPAND_SYSTEM);
+			// pSE is system times environment, system index fastest
+			size_t ns = (expandSystem) ? pSE.size()/total : total;
+
+			std::vector<DensityMatrixElementType> psi;
+			std::vector<DensityMatrixElementType> column(length);
+			size_t cols = 0;
+			for (size_t beta=0;beta<total;beta++) {
+				bool nonZero = false;
+				for (size_t i=0;i<length;i++) {
+					size_t alpha = i + start;
+					size_t x = (expandSystem) ? alpha + beta*ns : beta + alpha*ns;
+					column[i] = v[pSE.permutationInverse(x)];
+					if (column[i]!=static_cast<DensityMatrixElementType>(0.0)) nonZero = true;
 				}
+				if (!nonZero) continue;
+				psi.insert(psi.end(),column.begin(),column.end());
+				cols++;
 			}
-		}
 
-		DensityMatrixElementType densityMatrixExpandEnviron(
-			size_t alpha1,
-			size_t alpha2,
-			const TargetVectorType& v,
-			size_t total,
-			BasisType const &pSE,
-			size_t ns,
-			size_t ne)
-		{
-			DensityMatrixElementType sum=0;
+			if (cols==0) return;
 
-			size_t x2 = alpha2*ns;
-			size_t x1 = alpha1*ns;
-			for (size_t beta=0;beta<total;beta++) {
-				size_t jj = pSE.permutationInverse(beta + x2);
-				size_t ii = pSE.permutationInverse(beta + x1);
-				sum += v[ii] * std::conj(v[jj]);
-			}
-			return sum;
+			DensityMatrixElementType w = weight;
+			DensityMatrixElementType one = 1.0;
+			psimag::BLAS::GEMM('N','C',length,length,cols,w,&(psi[0]),length,
+					   &(psi[0]),length,one,&(matrixBlock(0,0)),length);
 		}
 
-		DensityMatrixElementType densityMatrixExpandSystem(
-			size_t alpha1,
-			size_t alpha2,
-			const TargetVectorType& v,
-			size_t total,
-			BasisType const &pSE,
-			size_t ns,
-			size_t ne)
-		{
-			DensityMatrixElementType sum=0;
-
-			size_t totalNs = total * ns;
-
-			for (size_t betaNs=0;betaNs<totalNs;betaNs+=ns) {
-				size_t jj = pSE.permutationInverse(alpha2+betaNs);
-				size_t ii = pSE.permutationInverse(alpha1+betaNs);
-				sum += v[ii] * std::conj(v[jj]);
-			}
-			return sum;
-		}
+	private:
 
 		const TargettingType& target_;
 		const BasisWithOperatorsType& pBasis_;
 		const BasisWithOperatorsType& pBasisSummed_;
 		const BasisType& pSE_;
 		int direction_;
-		size_t m_;
-		BuildingBlockType& matrixBlock_;
+		size_t gsOffset_;
+		size_t targets_;
+		std::vector<size_t> firstBlock_;
+		std::vector<std::vector<BuildingBlockType> > partial_;
 	}; // class ParallelDensityMatrix
 } // namespace Dmrg 
 
@@ -255,6 +255,55 @@ namespace Dmrg {
 
 	\\inputSubItem{nofiniteloops}  Don't do finite loops, even if provided under ``FiniteLoops'' below.
 
+	\\inputSubItem{adaptiveLanczosEps}  Set the tolerance of the eigensolver at each step to
+	0.01 times the truncation error of the previous step, between ``LanczosEps''
+	and $10^{-6}$. The last finite loop, and finite loops that save data to disk,
+	always use ``LanczosEps''.
+
+	\\inputSubItem{useBlockLanczos}  Find the ground state of each symmetry sector with a block
+	Lanczos that applies the Hamiltonian to ``LanczosBlockSize'' vectors at a time
+	(default 2). Only the lowest state is kept; the other vectors of the block
+	serve to speed up convergence. Ignored if reflection symmetry is used.
+
+	\\inputSubItem{useBlockedKernel}  Apply the system-environment connections with a kernel
+	that visits the superblock vector in tiles of rows sharing the environment state.
+	The result is the same; use it to compare performance on a given model.
+
+	\\inputSubItem{partialDensityMatrixDiag}  Compute only the eigenpairs of each block of the
+	density matrix that can be among the kept states, instead of all of them.
+	Ignored if SU(2) symmetry is used.
+
+	\\inputSubItem{lazyOperators}  Do not transform the operators of the system and environment
+	blocks at each step, but record the changes of basis and apply them to an operator only
+	when it is used, for example by a connection of the Hamiltonian. Operators of sites far
+	from the center of the lattice are then rarely, if ever, transformed.
+	Ignored if SU(2) symmetry is used.
+
+	\\inputSubItem{onlyNeededOperators}  Keep, in the system and environment blocks, only the
+	operators of the sites that are within the geometry's maximum connection distance
+	of the other block; the operators of all other sites are dropped when the basis is
+	truncated. Observables are not affected, since they are computed from the saved
+	transformations and site operators. Ignored if SU(2) symmetry is used.
+
+	\\inputSubItem{binaryStacks}  Write the checkpoint stacks of system and environment blocks
+	in a binary format with an index of byte offsets and a checksum per block, instead of
+	text. Restarts then read each block with a seek instead of scanning the file. The
+	stacks of the run being restarted must have been written with this option too.
+
+	\\inputSubItem{binaryData}  Write the data needed by observe, that is, the
+	serialized step and the target's vectors at each finite step, to a binary file named
+	as the data file with a .bin suffix, with an index of byte offsets and a checksum per
+	step, instead of to the text data file. observe reads it in place from a memory map
+	when the same option is given in its input file.
+
+	\\inputSubItem{exportTextData}  With binaryData, write the text data of each finite
+	step to the data file as well.
+
+	\\inputSubItem{saveOperators}  At each finite step, save the operators of the system
+	and environment blocks to the data file. By default only what observe needs is saved:
+	the bases with their permutations and partitions, the block Hamiltonians, the
+	fermionic signs, the wavefunction and the transformation.
+
 	\\inputItem{version}  A mandatory string that is read and ignored. Usually contains the result
 	of doing ``git rev-parse HEAD''.
 
@@ -278,6 +327,13 @@ namespace Dmrg {
 	electrons respectively. If there is SU(2) symmetry then this is 3 followed by $n_\\uparrow n_\\downarrow j$,
 	where $n_\\uparrow$, and $n_\\downarrow$ are the densities of up and down
 	electrons respectively, and $j$ is twice the angular momentum divided by the number of sites.
+	\\inputItem{BlockStackWindow} Optional. Number of grown blocks of each stack, system and environ,
+	to keep in memory; the others are written to scratch files next to the output file, and
+	read back ahead of time. Defaults to 0, which keeps all blocks in memory.
+	\\inputItem{ObserverMemoryBudget} Optional. Used by observe only, and only with the
+	binaryData option. Megabytes of saved steps to keep in memory; steps are then read
+	from the binary data file when first needed, and the least recently used ones are
+	dropped when over budget. Defaults to 0, which reads all steps of a sweep up front.
 	*/
 	template<typename FieldType,typename InputValidatorType>
 	struct ParametersDmrgSolver {
@@ -298,10 +354,14 @@ namespace Dmrg {
 		std::string insitu;
 		size_t lanczosSteps;
 		FieldType lanczosEps;
+		size_t lanczosBlockSize;
+		size_t blockStackWindow;
+		size_t observerMemoryBudget;
 
 		//! Read Dmrg parameters from inp file
 		ParametersDmrgSolver(InputValidatorType& io)
-			: lanczosSteps(200),lanczosEps(1e-12)
+			: lanczosSteps(200),lanczosEps(1e-12),lanczosBlockSize(2),blockStackWindow(0),
+			  observerMemoryBudget(0)
 		{
 			io.readline(model,"Model=");
 			io.readline(options,"SolverOptions=");
@@ -432,6 +492,24 @@ namespace Dmrg {
 			try {
 				io.readline(lanczosEps,"LanczosEps=");
 			} catch (std::exception& e) {}
+
+			try {
+				io.readline(lanczosBlockSize,"LanczosBlockSize=");
+			} catch (std::exception& e) {}
+
+			if (lanczosBlockSize==0) {
+				std::string s (__FILE__);
+				s += "\nFATAL: LanczosBlockSize cannot be zero\n";
+				throw std::runtime_error(s.c_str());
+			}
+
+			try {
+				io.readline(blockStackWindow,"BlockStackWindow=");
+			} catch (std::exception& e) {}
+
+			try {
+				io.readline(observerMemoryBudget,"ObserverMemoryBudget=");
+			} catch (std::exception& e) {}
 		}
 	};
 
@@ -452,6 +530,7 @@ namespace Dmrg {
 		os<<parameters.finiteLoop;
 		os<<"parameters.lanczosSteps="<<parameters.lanczosSteps<<"\n";
 		os<<"parameters.LanczosEps="<<parameters.lanczosEps<<"\n";
+		os<<"parameters.LanczosBlockSize="<<parameters.lanczosBlockSize<<"\n";
 
 		if (parameters.targetQuantumNumbers.size()>0) {
 			os<<"parameters.targetQuantumNumbers=";
@@ -465,6 +544,10 @@ namespace Dmrg {
 		if (parameters.tolerance>0)
 			os<<"parameters.tolerance="<<parameters.tolerance<<"\n";
 		os<<"parameters.nthreads="<<parameters.nthreads<<"\n";
+		if (parameters.blockStackWindow>0)
+			os<<"parameters.blockStackWindow="<<parameters.blockStackWindow<<"\n";
+		if (parameters.observerMemoryBudget>0)
+			os<<"parameters.observerMemoryBudget="<<parameters.observerMemoryBudget<<"\n";
 		os<<"parameters.useReflectionSymmetry="<<parameters.useReflectionSymmetry<<"\n";
 		if (parameters.checkpoint.filename!="")
 			os<<"parameters.restartFilename="<<parameters.checkpoint.filename<<"\n";
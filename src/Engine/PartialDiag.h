@@ -0,0 +1,217 @@
+/*
+Copyright (c) 2012, UT-Battelle, LLC
+All rights reserved
+
+[DMRG++, Version 2.0.0]
+[by G.A., Oak Ridge National Laboratory]
+
+UT Battelle Open Source Software License 11242008
+
+OPEN SOURCE LICENSE
+
+Subject to the conditions of this License, each
+contributor to this software hereby grants, free of
+charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), a
+perpetual, worldwide, non-exclusive, no-charge,
+royalty-free, irrevocable copyright license to use, copy,
+modify, merge, publish, distribute, and/or sublicense
+copies of the Software.
+
+1. Redistributions of Software must retain the above
+copyright and license notices, this list of conditions,
+and the following disclaimer.  Changes or modifications
+to, or derivative works of, the Software should be noted
+with comments and the contributor and organization's
+name.
+
+2. Neither the names of UT-Battelle, LLC or the
+Department of Energy nor the names of the Software
+contributors may be used to endorse or promote products
+derived from this software without specific prior written
+permission of UT-Battelle.
+
+3. The software and the end-user documentation included
+with the redistribution, with or without modification,
+must include the following acknowledgment:
+
+"This product includes software produced by UT-Battelle,
+LLC under Contract No. DE-AC05-00OR22725  with the
+Department of Energy."
+
+*********************************************************
+DISCLAIMER
+
+THE SOFTWARE IS SUPPLIED BY THE COPYRIGHT HOLDERS AND
+CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER, CONTRIBUTORS, UNITED STATES GOVERNMENT,
+OR THE UNITED STATES DEPARTMENT OF ENERGY BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+DAMAGE.
+
+NEITHER THE UNITED STATES GOVERNMENT, NOR THE UNITED
+STATES DEPARTMENT OF ENERGY, NOR THE COPYRIGHT OWNER, NOR
+ANY OF THEIR EMPLOYEES, REPRESENTS THAT THE USE OF ANY
+INFORMATION, DATA, APPARATUS, PRODUCT, OR PROCESS
+DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
+
+*********************************************************
+
+
+*/
+// END LICENSE BLOCK
+/** \ingroup DMRG */
+/*@{*/
+
+/*! \file PartialDiag.h
+ *
+ *  Computes only the k largest eigenpairs of a hermitian matrix with
+ *  the LAPACK MRRR driver (dsyevr and zheevr with range 'I').
+ *  On return the eigenvectors are in the last k columns of the matrix,
+ *  in increasing eigenvalue order as PsimagLite::diag would leave them,
+ *  and the other columns are zero
+ *
+ */
+
+#ifndef PARTIAL_DIAG_H
+#define PARTIAL_DIAG_H
+
+#include <vector>
+#include <complex>
+#include <stdexcept>
+#include <string>
+#include "Matrix.h" // in PsimagLite
+#include "TypeToString.h"
+
+extern "C" void dsyevr_(char*,char*,char*,int*,double*,int*,double*,double*,
+                        int*,int*,double*,int*,double*,double*,int*,int*,
+                        double*,int*,int*,int*,int*);
+
+extern "C" void zheevr_(char*,char*,char*,int*,std::complex<double>*,int*,
+                        double*,double*,int*,int*,double*,int*,double*,
+                        std::complex<double>*,int*,int*,std::complex<double>*,
+                        int*,double*,int*,int*,int*,int*);
+
+namespace Dmrg {
+
+	template<typename T>
+	void partialDiagCopy(PsimagLite::Matrix<T>& a,const std::vector<T>& z,size_t k)
+	{
+		size_t n = a.n_row();
+		for (size_t j=0;j<n-k;j++)
+			for (size_t i=0;i<n;i++)
+				a(i,j) = 0.0;
+		for (size_t j=0;j<k;j++)
+			for (size_t i=0;i<n;i++)
+				a(i,j+n-k) = z[i+j*n];
+	}
+
+	inline void partialDiagCheck(int info,int found,size_t k)
+	{
+		if (info==0 && found==int(k)) return;
+		std::string s(__FILE__);
+		s += ": partialDiag failed with info=" + ttos(info) + "\n";
+		throw std::runtime_error(s.c_str());
+	}
+
+	//! eigs(n-k..n-1) receives the k largest eigenvalues of a, in increasing order
+	inline void partialDiag(PsimagLite::Matrix<double>& a,std::vector<double>& eigs,size_t k)
+	{
+		char jobz = 'V';
+		char range = 'I';
+		char uplo = 'U';
+		int n = a.n_row();
+		int il = n - k + 1;
+		int iu = n;
+		double vl = 0;
+		double vu = 0;
+		double abstol = 0;
+		int found = 0;
+		int ldz = n;
+		int info = 0;
+		std::vector<double> w(n);
+		std::vector<double> z(n*k);
+		std::vector<int> isuppz(2*k);
+
+		// workspace query
+		int lwork = -1;
+		int liwork = -1;
+		double work1 = 0;
+		int iwork1 = 0;
+		dsyevr_(&jobz,&range,&uplo,&n,&(a(0,0)),&n,&vl,&vu,&il,&iu,&abstol,&found,
+		        &(w[0]),&(z[0]),&ldz,&(isuppz[0]),&work1,&lwork,&iwork1,&liwork,&info);
+		lwork = int(work1);
+		liwork = iwork1;
+		std::vector<double> work(lwork);
+		std::vector<int> iwork(liwork);
+
+		dsyevr_(&jobz,&range,&uplo,&n,&(a(0,0)),&n,&vl,&vu,&il,&iu,&abstol,&found,
+		        &(w[0]),&(z[0]),&ldz,&(isuppz[0]),&(work[0]),&lwork,&(iwork[0]),
+		        &liwork,&info);
+		partialDiagCheck(info,found,k);
+
+		eigs.resize(n);
+		for (size_t j=0;j<k;j++) eigs[j+n-k] = w[j];
+		partialDiagCopy(a,z,k);
+	}
+
+	inline void partialDiag(PsimagLite::Matrix<std::complex<double> >& a,
+	                        std::vector<double>& eigs,
+	                        size_t k)
+	{
+		char jobz = 'V';
+		char range = 'I';
+		char uplo = 'U';
+		int n = a.n_row();
+		int il = n - k + 1;
+		int iu = n;
+		double vl = 0;
+		double vu = 0;
+		double abstol = 0;
+		int found = 0;
+		int ldz = n;
+		int info = 0;
+		std::vector<double> w(n);
+		std::vector<std::complex<double> > z(n*k);
+		std::vector<int> isuppz(2*k);
+
+		// workspace query
+		int lwork = -1;
+		int lrwork = -1;
+		int liwork = -1;
+		std::complex<double> work1 = 0;
+		double rwork1 = 0;
+		int iwork1 = 0;
+		zheevr_(&jobz,&range,&uplo,&n,&(a(0,0)),&n,&vl,&vu,&il,&iu,&abstol,&found,
+		        &(w[0]),&(z[0]),&ldz,&(isuppz[0]),&work1,&lwork,&rwork1,&lrwork,
+		        &iwork1,&liwork,&info);
+		lwork = int(std::real(work1));
+		lrwork = int(rwork1);
+		liwork = iwork1;
+		std::vector<std::complex<double> > work(lwork);
+		std::vector<double> rwork(lrwork);
+		std::vector<int> iwork(liwork);
+
+		zheevr_(&jobz,&range,&uplo,&n,&(a(0,0)),&n,&vl,&vu,&il,&iu,&abstol,&found,
+		        &(w[0]),&(z[0]),&ldz,&(isuppz[0]),&(work[0]),&lwork,&(rwork[0]),
+		        &lrwork,&(iwork[0]),&liwork,&info);
+		partialDiagCheck(info,found,k);
+
+		eigs.resize(n);
+		for (size_t j=0;j<k;j++) eigs[j+n-k] = w[j];
+		partialDiagCopy(a,z,k);
+	}
+} // namespace Dmrg
+
+/*@}*/
+#endif // PARTIAL_DIAG_H
@@ -96,6 +96,15 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #endif  // #ifdef USE_THREADS_WITH_MPI
 #endif // #ifdef USE_PTHREADS
 
+// Threads within one process, for loops that must cover all their
+// items in every process, or whose items were already split over processes
+#ifdef USE_PTHREADS
+#define LOCAL_PTHREADS_NAME PsimagLite::Pthreads
+#else
+#include "NoPthreads.h"
+#define LOCAL_PTHREADS_NAME PsimagLite::NoPthreads
+#endif // #ifdef USE_PTHREADS
+
 namespace Dmrg {
 	struct ProgramGlobals {
 		static size_t const MaxNumberOfSites = 300; // max number of sites that a model can use
@@ -0,0 +1,153 @@
+/*
+Copyright (c) 2012, UT-Battelle, LLC
+All rights reserved
+
+[DMRG++, Version 2.0.0]
+[by G.A., Oak Ridge National Laboratory]
+
+UT Battelle Open Source Software License 11242008
+
+OPEN SOURCE LICENSE
+
+Subject to the conditions of this License, each
+contributor to this software hereby grants, free of
+charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), a
+perpetual, worldwide, non-exclusive, no-charge,
+royalty-free, irrevocable copyright license to use, copy,
+modify, merge, publish, distribute, and/or sublicense
+copies of the Software.
+
+1. Redistributions of Software must retain the above
+copyright and license notices, this list of conditions,
+and the following disclaimer.  Changes or modifications
+to, or derivative works of, the Software should be noted
+with comments and the contributor and organization's
+name.
+
+2. Neither the names of UT-Battelle, LLC or the
+Department of Energy nor the names of the Software
+contributors may be used to endorse or promote products
+derived from this software without specific prior written
+permission of UT-Battelle.
+
+3. The software and the end-user documentation included
+with the redistribution, with or without modification,
+must include the following acknowledgment:
+
+"This product includes software produced by UT-Battelle,
+LLC under Contract No. DE-AC05-00OR22725  with the
+Department of Energy."
+
+*********************************************************
+DISCLAIMER
+
+THE SOFTWARE IS SUPPLIED BY THE COPYRIGHT HOLDERS AND
+CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+COPYRIGHT OWNER, CONTRIBUTORS, UNITED STATES GOVERNMENT,
+OR THE UNITED STATES DEPARTMENT OF ENERGY BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+DAMAGE.
+
+NEITHER THE UNITED STATES GOVERNMENT, NOR THE UNITED
+STATES DEPARTMENT OF ENERGY, NOR THE COPYRIGHT OWNER, NOR
+ANY OF THEIR EMPLOYEES, REPRESENTS THAT THE USE OF ANY
+INFORMATION, DATA, APPARATUS, PRODUCT, OR PROCESS
+DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
+
+*********************************************************
+
+
+*/
+// END LICENSE BLOCK
+/** \ingroup DMRG */
+/*@{*/
+
+/*! \file SectorIndexMap.h
+ *
+ *  Maps a pair (alpha,beta) of system and environment states to its
+ *  row in one symmetry sector of the superblock, or to -1 if the pair
+ *  does not belong to the sector.
+ *  For each alpha only the window of betas between the smallest and
+ *  largest valid beta is stored, so memory is of the order of the
+ *  sector size instead of left.size() times right.size()
+ *
+ */
+
+#ifndef SECTOR_INDEX_MAP_H
+#define SECTOR_INDEX_MAP_H
+
+#include <vector>
+#include <cassert>
+
+namespace Dmrg {
+
+class SectorIndexMap {
+
+public:
+
+	SectorIndexMap() {}
+
+	//! Row i of the sector is the pair (alpha[i],beta[i]), ns is the size of the system
+	SectorIndexMap(const std::vector<size_t>& alpha,
+	               const std::vector<size_t>& beta,
+	               size_t ns)
+	: offset_(ns,0),start_(ns,0),length_(ns,0)
+	{
+		assert(alpha.size()==beta.size());
+		std::vector<size_t> betaMax(ns,0);
+		for (size_t i=0;i<alpha.size();i++) {
+			size_t a = alpha[i];
+			assert(a<ns);
+			if (length_[a]==0 || beta[i]<start_[a]) start_[a] = beta[i];
+			if (length_[a]==0 || beta[i]>betaMax[a]) betaMax[a] = beta[i];
+			length_[a] = 1;
+		}
+
+		size_t counter = 0;
+		for (size_t a=0;a<ns;a++) {
+			offset_[a] = counter;
+			if (length_[a]==0) continue;
+			length_[a] = betaMax[a] - start_[a] + 1;
+			counter += length_[a];
+		}
+
+		data_.resize(counter,-1);
+		for (size_t i=0;i<alpha.size();i++) {
+			size_t a = alpha[i];
+			data_[offset_[a] + beta[i] - start_[a]] = i;
+		}
+	}
+
+	int operator()(size_t alpha,size_t beta) const
+	{
+		assert(alpha<length_.size());
+		// unsigned wrap-around also rejects beta<start_[alpha]
+		size_t b = beta - start_[alpha];
+		if (b>=length_[alpha]) return -1;
+		return data_[offset_[alpha] + b];
+	}
+
+private:
+
+	std::vector<size_t> offset_;
+	std::vector<size_t> start_;
+	std::vector<size_t> length_;
+	std::vector<int> data_;
+}; // class SectorIndexMap
+
+} // namespace Dmrg
+
+/*@}*/
+
+#endif // SECTOR_INDEX_MAP_H
@@ -80,6 +80,7 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #define TIME_SERIAL_H
 
 #include "IoSimple.h"
+#include "IoBinaryFile.h"
 #include "TypeToString.h"
 
 namespace Dmrg {
@@ -104,31 +105,17 @@ namespace Dmrg {
 			
 			TimeSerializer(typename PsimagLite::IoSimple::In& io,size_t lastInstance = 0)
 			{
-				RealType x=0;
-				std::string s = "#TIME=";
-				if (lastInstance) io.readline(x,s,lastInstance);
-				else io.readline(x,s);
-				if (x<0) throw std::runtime_error("TimeSerializer:: time cannot be negative\n");
-				currentTime_ = x;
-				
-				s = "#TCENTRALSITE=";
-				int xi=0;
-				io.readline(xi,s);
-				if (xi<0) throw std::runtime_error("TimeSerializer:: site cannot be negative\n");
-				site_ = xi;
-				
-				s = "#TNUMBEROFVECTORS=";
-				io.readline(xi,s);
-				if (xi<=0) throw std::runtime_error("TimeSerializer:: n. of vectors must be positive\n");
-				targetVectors_.resize(xi);
-				for (size_t i=0;i<targetVectors_.size();i++) {
-					s = "targetVector"+ttos(i);
-					targetVectors_[i].load(io,s);
-				}
-				s = "#MARKER=";
-				io.readline(xi,s);
-				if (xi<0) throw std::runtime_error("TimeSerializer:: marker must be positive\n");
-				marker_=xi;
+				load(io,lastInstance);
+			}
+
+			TimeSerializer(IoBinaryFile::In& io,size_t lastInstance = 0)
+			{
+				load(io,lastInstance);
+			}
+
+			TimeSerializer(IoBinary::In& io,size_t lastInstance = 0)
+			{
+				load(io,lastInstance);
 			}
 			
 			size_t size(size_t i=0) const
@@ -180,6 +167,37 @@ namespace Dmrg {
 			}
 
 		private:
+
+			template<typename IoInputter>
+			void load(IoInputter& io,size_t lastInstance)
+			{
+				RealType x=0;
+				std::string s = "#TIME=";
+				if (lastInstance) io.readline(x,s,lastInstance);
+				else io.readline(x,s);
+				if (x<0) throw std::runtime_error("TimeSerializer:: time cannot be negative\n");
+				currentTime_ = x;
+				
+				s = "#TCENTRALSITE=";
+				int xi=0;
+				io.readline(xi,s);
+				if (xi<0) throw std::runtime_error("TimeSerializer:: site cannot be negative\n");
+				site_ = xi;
+				
+				s = "#TNUMBEROFVECTORS=";
+				io.readline(xi,s);
+				if (xi<=0) throw std::runtime_error("TimeSerializer:: n. of vectors must be positive\n");
+				targetVectors_.resize(xi);
+				for (size_t i=0;i<targetVectors_.size();i++) {
+					s = "targetVector"+ttos(i);
+					targetVectors_[i].load(io,s);
+				}
+				s = "#MARKER=";
+				io.readline(xi,s);
+				if (xi<0) throw std::runtime_error("TimeSerializer:: marker must be positive\n");
+				marker_=xi;
+			}
+
 			RealType currentTime_;
 			size_t site_;
 			std::vector<VectorType> targetVectors_;
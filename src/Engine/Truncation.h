@@ -221,7 +221,10 @@ namespace Dmrg {
 
 			TruncationCache& cache = (direction==EXPAND_SYSTEM) ? leftCache_ : rightCache_;
 
-			dmS.diag(cache.eigs,'V',concurrency_);
+			if (parameters_.options.find("partialDensityMatrixDiag")!=std::string::npos)
+				dmS.diagPartial(cache.eigs,keptStates,concurrency_);
+			else
+				dmS.diag(cache.eigs,'V',concurrency_);
 			dmS.check2(direction);
 			updateKeptStates(keptStates,cache.eigs);
 
@@ -244,7 +247,8 @@ namespace Dmrg {
 			TruncationCache& cache = leftCache_;
 
 			rSprime.truncateBasis(ftransform_,cache.transform,
-							    cache.eigs,cache.removedIndices,concurrency_);
+							    cache.eigs,cache.removedIndices,concurrency_,
+							    parameters_.nthreads,borderSites(),true);
 			LeftRightSuperType lrs(rSprime,(BasisWithOperatorsType&) eBasis,
 					       (BasisType&)lrs_.super());
 			waveFunctionTransformation_.push(ftransform_,EXPAND_SYSTEM,lrs);
@@ -260,7 +264,8 @@ namespace Dmrg {
 			TruncationCache& cache = rightCache_;
 
 			rEprime.truncateBasis(ftransform_,cache.transform,
-							    cache.eigs,cache.removedIndices,concurrency_);
+							    cache.eigs,cache.removedIndices,concurrency_,
+							    parameters_.nthreads,borderSites(),false);
 			LeftRightSuperType lrs((BasisWithOperatorsType&) sBasis,
 					       rEprime,(BasisType&)lrs_.super());
 			waveFunctionTransformation_.push(ftransform_,EXPAND_ENVIRON,lrs);
@@ -269,6 +274,16 @@ namespace Dmrg {
 		}
 
 
+		//! With onlyNeededOperators, the number of sites next to the border of
+		//! a block whose operators can still be connected to a site outside
+		//! of it; zero means keep all
+		size_t borderSites() const
+		{
+			if (parameters_.options.find("onlyNeededOperators")==std::string::npos)
+				return 0;
+			return maxConnections_;
+		}
+
 		void updateKeptStates(size_t& keptStates,const std::vector<RealType>& eigs2)
 		{
 			std::vector<RealType> eigs = eigs2;
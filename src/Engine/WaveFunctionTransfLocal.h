@@ -88,6 +88,7 @@ DISCLOSED WOULD NOT INFRINGE PRIVATELY OWNED RIGHTS.
 #include "VectorWithOffsets.h" // so that std::norm() becomes visible here
 #include "VectorWithOffset.h" // so that std::norm() becomes visible here
 #include "WaveFunctionTransfBase.h"
+#include "CrsMatrixArena.h"
 
 namespace Dmrg {
 	
@@ -103,6 +104,7 @@ namespace Dmrg {
 		typedef typename BasisWithOperatorsType::SparseMatrixType SparseMatrixType;
 		typedef typename BasisWithOperatorsType::BasisType BasisType;
 		typedef typename SparseMatrixType::value_type SparseElementType;
+		typedef ArenaMatrix<SparseMatrixType> ArenaMatrixType;
 		typedef std::vector<SparseElementType> VectorType;
 		typedef typename BasisWithOperatorsType::RealType RealType;
 		typedef typename BasisType::FactorsType FactorsType;
@@ -198,10 +200,10 @@ namespace Dmrg {
 			size_t start = psiDest.offset(i0);
 			size_t final = psiDest.effectiveSize(i0)+start;
 			
-			SparseMatrixType ws(dmrgWaveStruct_.ws);
-			SparseMatrixType we(dmrgWaveStruct_.we);
-			SparseMatrixType weT;
-			transposeConjugate(weT,we);
+			const SparseMatrixType& ws = dmrgWaveStruct_.ws;
+			ArenaMatrixType arenaWeT;
+			SparseMatrixType& weT = arenaWeT();
+			transposeConjugate(weT,dmrgWaveStruct_.we);
 			
 			PackIndicesType pack1(nip);
 			PackIndicesType pack2(nk);
@@ -289,10 +291,10 @@ namespace Dmrg {
 			size_t start = psiDest.offset(i0);
 			size_t final = psiDest.effectiveSize(i0)+start;
 			
-			SparseMatrixType we(dmrgWaveStruct_.we);
-			SparseMatrixType ws(dmrgWaveStruct_.ws);
-			SparseMatrixType wsT;
-			transposeConjugate(wsT,ws);
+			const SparseMatrixType& we = dmrgWaveStruct_.we;
+			ArenaMatrixType arenaWsT;
+			SparseMatrixType& wsT = arenaWsT();
+			transposeConjugate(wsT,dmrgWaveStruct_.ws);
 			
 			PackIndicesType pack1(nalpha);
 			PackIndicesType pack2(nip);
@@ -384,10 +386,10 @@ namespace Dmrg {
 			size_t start = psiDest.offset(i0);
 			size_t final = psiDest.effectiveSize(i0)+start;
 			
-			SparseMatrixType we(dmrgWaveStruct_.we);
-			SparseMatrixType ws(dmrgWaveStruct_.ws);
-			SparseMatrixType wsT;
-			transposeConjugate(wsT,ws);
+			const SparseMatrixType& we = dmrgWaveStruct_.we;
+			ArenaMatrixType arenaWsT;
+			SparseMatrixType& wsT = arenaWsT();
+			transposeConjugate(wsT,dmrgWaveStruct_.ws);
 			
 			PackIndicesType pack1(nalpha);
 			PackIndicesType pack2(nip);
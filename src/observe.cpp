@@ -22,6 +22,7 @@ typedef double RealType;
 #include "Observer.h"
 #include "ObservableLibrary.h"
 #include "IoSimple.h"
+#include "IoBinaryFile.h"
 #include "ModelFactory.h"
 #include "OperatorsBase.h"
 #ifndef USE_MPI
@@ -74,9 +75,9 @@ size_t dofsFromModelName(const ModelType& model)
 	return 0;
 }
 
-template<typename VectorWithOffsetType,typename ModelType,typename SparseMatrixType,typename OperatorType,typename TargettingType>
+template<typename VectorWithOffsetType,typename ModelType,typename SparseMatrixType,typename OperatorType,typename TargettingType,typename IoDataType>
 bool observeOneFullSweep(
-	IoInputType& io,
+	IoDataType& io,
 	const GeometryType& geometry,
 	const ModelType& model,
 	const std::string& obsOptions,
@@ -85,7 +86,7 @@ bool observeOneFullSweep(
 {
 	bool verbose = false;
 	typedef typename SparseMatrixType::value_type FieldType;
-	typedef Observer<FieldType,VectorWithOffsetType,ModelType,IoInputType> 
+	typedef Observer<FieldType,VectorWithOffsetType,ModelType,IoDataType> 
 		ObserverType;
 	typedef ObservableLibrary<ObserverType,TargettingType> ObservableLibraryType;
 	size_t n  = geometry.numberOfSites();
@@ -158,6 +159,31 @@ bool observeOneFullSweep(
 	return observerLib.endOfData();
 }
 
+template<typename VectorWithOffsetType,typename ModelType,typename SparseMatrixType,typename OperatorType,typename TargettingType,typename IoDataType>
+void observeAllSweeps(
+	IoDataType& dataIo,
+	const GeometryType& geometry,
+	const ModelType& model,
+	const std::string& obsOptions,
+	bool hasTimeEvolution,
+	ConcurrencyType& concurrency)
+{
+	bool moreData = true;
+	while (moreData) {
+		try {
+			moreData = !observeOneFullSweep<VectorWithOffsetType,ModelType,
+			            SparseMatrixType,OperatorType,TargettingType>
+			(dataIo,geometry,model,obsOptions,hasTimeEvolution,concurrency);
+		} catch (std::exception& e) {
+			std::cerr<<"CAUGHT: "<<e.what();
+			std::cerr<<"There's no more data\n";
+			break;
+		}
+
+		//if (!hasTimeEvolution) break;
+	}
+}
+
 template<template<typename,typename> class ModelHelperTemplate,
          template<typename> class VectorWithOffsetTemplate,
          template<template<typename,typename,typename> class,
@@ -199,23 +225,17 @@ void mainLoop(GeometryType& geometry,
 	typedef typename TargettingType::TargettingParamsType TargettingParamsType;
 	TargettingParamsType tsp(io,model);
 	
-	bool moreData = true;
 	const std::string& datafile = params.filename;
-	IoInputType dataIo(datafile);
 	bool hasTimeEvolution = (targetting == "TimeStepTargetting") ? true : false;
-	while (moreData) {
-		try {
-			moreData = !observeOneFullSweep<VectorWithOffsetType,ModelType,
-			            SparseMatrixType,OperatorType,TargettingType>
-			(dataIo,geometry,model,obsOptions,hasTimeEvolution,concurrency);
-		} catch (std::exception& e) {
-			std::cerr<<"CAUGHT: "<<e.what();
-			std::cerr<<"There's no more data\n";
-			break;
-		}
-
-		//if (!hasTimeEvolution) break;
+	if (params.options.find("binaryData")!=std::string::npos) {
+		IoBinaryFile::In dataIo(IoBinaryFile::name(datafile));
+		observeAllSweeps<VectorWithOffsetType,ModelType,SparseMatrixType,OperatorType,TargettingType>
+		(dataIo,geometry,model,obsOptions,hasTimeEvolution,concurrency);
+		return;
 	}
+	IoInputType dataIo(datafile);
+	observeAllSweeps<VectorWithOffsetType,ModelType,SparseMatrixType,OperatorType,TargettingType>
+	(dataIo,geometry,model,obsOptions,hasTimeEvolution,concurrency);
 }
 
 void usage(const char* name)